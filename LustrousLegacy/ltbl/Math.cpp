@@ -5,6 +5,7 @@
 #include <assert.h>
 
 #include <cmath>
+#include <algorithm>
 
 using namespace ltbl;
 
@@ -181,7 +182,16 @@ bool ltbl::shapeIntersection(const sf::ConvexShape &left, const sf::ConvexShape
 }
 
 sf::ConvexShape ltbl::shapeFromRect(const sf::FloatRect &rect) {
-	sf::ConvexShape shape(4);
+	sf::ConvexShape shape;
+
+	shapeFromRect(rect, shape);
+
+	return shape;
+}
+
+void ltbl::shapeFromRect(const sf::FloatRect &rect, sf::ConvexShape &shape) {
+	// Reuses the point storage of the shape if it already has 4 points
+	shape.setPointCount(4);
 
 	sf::Vector2f halfDims = rectHalfDims(rect);
 
@@ -191,8 +201,6 @@ sf::ConvexShape ltbl::shapeFromRect(const sf::FloatRect &rect) {
 	shape.setPoint(3, sf::Vector2f(-halfDims.x, halfDims.y));
 
 	shape.setPosition(rectCenter(rect));
-
-	return shape;
 }
 
 sf::ConvexShape ltbl::shapeFixWinding(const sf::ConvexShape &shape) {
@@ -268,4 +276,118 @@ bool ltbl::rayIntersect(const sf::Vector2f &as, const sf::Vector2f &ad, const sf
 	intersection = as + ad * u;
 
 	return true;
-}
\ No newline at end of file
+}
+
+float ltbl::rectDistanceSquared(const sf::FloatRect &rect, const sf::Vector2f &point) {
+	float dx = std::max(std::max(rect.left - point.x, point.x - (rect.left + rect.width)), 0.0f);
+	float dy = std::max(std::max(rect.top - point.y, point.y - (rect.top + rect.height)), 0.0f);
+
+	return dx * dx + dy * dy;
+}
+
+bool ltbl::rayRectIntersect(const sf::Vector2f &origin, const sf::Vector2f &direction, float maxDistance, const sf::FloatRect &rect, float &distance) {
+	// Slab test, each axis narrows the interval of the ray inside the rectangle
+	float enterDistance = 0.0f;
+	float exitDistance = maxDistance;
+
+	const float origins[2] = { origin.x, origin.y };
+	const float directions[2] = { direction.x, direction.y };
+	const float lowerBounds[2] = { rect.left, rect.top };
+	const float upperBounds[2] = { rect.left + rect.width, rect.top + rect.height };
+
+	for (int i = 0; i < 2; i++) {
+		if (directions[i] == 0.0f) {
+			// Parallel to the slab, either always inside it or never
+			if (origins[i] < lowerBounds[i] || origins[i] > upperBounds[i])
+				return false;
+
+			continue;
+		}
+
+		float inverse = 1.0f / directions[i];
+		float slabEnter = (lowerBounds[i] - origins[i]) * inverse;
+		float slabExit = (upperBounds[i] - origins[i]) * inverse;
+
+		if (slabEnter > slabExit)
+			std::swap(slabEnter, slabExit);
+
+		enterDistance = std::max(enterDistance, slabEnter);
+		exitDistance = std::min(exitDistance, slabExit);
+
+		if (enterDistance > exitDistance)
+			return false;
+	}
+
+	distance = enterDistance;
+
+	return true;
+}
+
+ShapeAxes::ShapeAxes(const sf::ConvexShape &shape)
+: _numAxes(0)
+{
+	const sf::Transform &transform = shape.getTransform();
+	size_t numPoints = shape.getPointCount();
+
+	assert(numPoints > 0);
+
+	_lowerBound = _upperBound = transform.transformPoint(shape.getPoint(0));
+
+	for (size_t i = 1; i < numPoints; i++) {
+		sf::Vector2f point = transform.transformPoint(shape.getPoint(i));
+
+		_lowerBound.x = std::min(_lowerBound.x, point.x);
+		_lowerBound.y = std::min(_lowerBound.y, point.y);
+		_upperBound.x = std::max(_upperBound.x, point.x);
+		_upperBound.y = std::max(_upperBound.y, point.y);
+	}
+
+	for (size_t i = 0; i < numPoints; i++) {
+		sf::Vector2f edge = transform.transformPoint(shape.getPoint((i + 1) % numPoints)) - transform.transformPoint(shape.getPoint(i));
+
+		if (edge.x == 0.0f && edge.y == 0.0f)
+			continue;
+
+		// Projections are only compared with each other, so the normal need not be unit length
+		Axis axis;
+		axis._normal = sf::Vector2f(edge.y, -edge.x);
+		axis._min = axis._max = vectorDot(transform.transformPoint(shape.getPoint(0)), axis._normal);
+
+		for (size_t j = 1; j < numPoints; j++) {
+			float proj = vectorDot(transform.transformPoint(shape.getPoint(j)), axis._normal);
+
+			axis._min = std::min(axis._min, proj);
+			axis._max = std::max(axis._max, proj);
+		}
+
+		if (_numAxes < _inlineCapacity)
+			_inline[_numAxes] = axis;
+		else
+			_overflow.push_back(axis);
+
+		_numAxes++;
+	}
+}
+
+bool ShapeAxes::intersects(const sf::FloatRect &rect) const {
+	// Rectangle axes
+	if (rect.left > _upperBound.x || rect.left + rect.width < _lowerBound.x ||
+		rect.top > _upperBound.y || rect.top + rect.height < _lowerBound.y)
+		return false;
+
+	// Shape axes, the rectangle projects to its center plus or minus its half extents
+	sf::Vector2f center = rectCenter(rect);
+	sf::Vector2f halfDims = rectHalfDims(rect);
+
+	for (size_t i = 0; i < _numAxes; i++) {
+		const Axis &axis = getAxis(i);
+
+		float centerProj = vectorDot(center, axis._normal);
+		float radiusProj = halfDims.x * std::abs(axis._normal.x) + halfDims.y * std::abs(axis._normal.y);
+
+		if (centerProj - radiusProj > axis._max || centerProj + radiusProj < axis._min)
+			return false;
+	}
+
+	return true;
+}
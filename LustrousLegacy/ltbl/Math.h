@@ -2,6 +2,9 @@
 
 #include <SFML/Graphics.hpp>
 
+#include <array>
+#include <vector>
+
 namespace ltbl {
 	const float _pi = 3.14159265f;
 	const float _radToDeg = 180.0f / _pi;
@@ -23,6 +26,44 @@ namespace ltbl {
 	sf::FloatRect rectExpand(const sf::FloatRect &rect, const sf::Vector2f &point);
 	bool shapeIntersection(const sf::ConvexShape &left, const sf::ConvexShape &right);
 	sf::ConvexShape shapeFromRect(const sf::FloatRect &rect);
+	void shapeFromRect(const sf::FloatRect &rect, sf::ConvexShape &shape);
 	sf::ConvexShape shapeFixWinding(const sf::ConvexShape &shape);
 	bool rayIntersect(const sf::Vector2f &as, const sf::Vector2f &ad, const sf::Vector2f &bs, const sf::Vector2f &bd, sf::Vector2f &intersection);
+
+	// Squared distance from the point to the closest point of the rectangle, 0 if inside
+	float rectDistanceSquared(const sf::FloatRect &rect, const sf::Vector2f &point);
+
+	// Distance along a ray (unit direction) to where it enters the rectangle, 0 if the origin
+	// is inside. Returns false if the ray misses or enters beyond maxDistance
+	bool rayRectIntersect(const sf::Vector2f &origin, const sf::Vector2f &direction, float maxDistance, const sf::FloatRect &rect, float &distance);
+
+	// Separating axes of a transformed convex shape, computed once and then tested
+	// against many rectangles without building shapes or touching the heap.
+	// Like shapeIntersection, touching counts as intersecting
+	class ShapeAxes {
+	private:
+		struct Axis {
+			sf::Vector2f _normal;
+			float _min, _max;
+		};
+
+		static const size_t _inlineCapacity = 16;
+
+		std::array<Axis, _inlineCapacity> _inline;
+		std::vector<Axis> _overflow;
+
+		size_t _numAxes;
+
+		// Projection onto the rectangle axes
+		sf::Vector2f _lowerBound, _upperBound;
+
+		const Axis &getAxis(size_t index) const {
+			return index < _inlineCapacity ? _inline[index] : _overflow[index - _inlineCapacity];
+		}
+
+	public:
+		ShapeAxes(const sf::ConvexShape &shape);
+
+		bool intersects(const sf::FloatRect &rect) const;
+	};
 }
\ No newline at end of file
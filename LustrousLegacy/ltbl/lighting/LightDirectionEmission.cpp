@@ -24,40 +24,54 @@ void LightDirectionEmission::render(const sf::View &view, sf::RenderTexture &lig
 		std::vector<sf::Vector2f> innerBoundaryVectors;
 		std::vector<sf::Vector2f> outerBoundaryVectors;
 
-		LightSystem::getPenumbrasDirection(penumbras, innerBoundaryIndices, innerBoundaryVectors, outerBoundaryIndices, outerBoundaryVectors, pLightShape->_shape, _castDirection, _sourceRadius, _sourceDistance);
+		const ShadowCaster &caster = pLightShape->getShadowCaster();
+
+		LightSystem::getPenumbrasDirection(penumbras, innerBoundaryIndices, innerBoundaryVectors, outerBoundaryIndices, outerBoundaryVectors, caster, _castDirection, _sourceRadius, _sourceDistance);
 
 		if (innerBoundaryIndices.size() != 2 || outerBoundaryIndices.size() != 2)
 			continue;
 
-		LightSystem::clear(antumbraTempTexture, sf::Color::White);
+		float maxDist = 0.0f;
 
-		antumbraTempTexture.setView(view);
+		for (int j = 0; j < caster.getPointCount(); j++)
+			maxDist = std::max(maxDist, vectorMagnitude(view.getCenter() - caster.getPoint(j)));
 
-		sf::ConvexShape maskShape;
+		float totalShadowExtension = shadowExtension + maxDist;
 
-		float maxDist = 0.0f;
+		sf::Vector2f as = caster.getPoint(innerBoundaryIndices[0]);
+		sf::Vector2f bs = caster.getPoint(innerBoundaryIndices[1]);
 
-		for (int j = 0; j < pLightShape->_shape.getPointCount(); j++)
-			maxDist = std::max(maxDist, vectorMagnitude(view.getCenter() - pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(j))));
+		sf::Vertex maskVertices[4] = {
+			sf::Vertex(as, sf::Color::Black),
+			sf::Vertex(bs, sf::Color::Black),
+			sf::Vertex(bs + vectorNormalize(innerBoundaryVectors[1]) * totalShadowExtension, sf::Color::Black),
+			sf::Vertex(as + vectorNormalize(innerBoundaryVectors[0]) * totalShadowExtension, sf::Color::Black)
+		};
 
-		float totalShadowExtension = shadowExtension + maxDist;
+		_penumbraVertices.clear();
+
+		for (int j = 0; j < penumbras.size(); j++)
+			LightSystem::appendPenumbra(_penumbraVertices, penumbras[j], totalShadowExtension);
 
-		maskShape.setPointCount(4);
+		// Only the pixels the shadow reaches go through the antumbra texture
+		sf::FloatRect bounds = rectFromBounds(maskVertices[0].position, maskVertices[0].position);
 
-		maskShape.setPoint(0, pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(innerBoundaryIndices[0])));
-		maskShape.setPoint(1, pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(innerBoundaryIndices[1])));
-		maskShape.setPoint(2, pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(innerBoundaryIndices[1])) + vectorNormalize(innerBoundaryVectors[1]) * totalShadowExtension);
-		maskShape.setPoint(3, pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(innerBoundaryIndices[0])) + vectorNormalize(innerBoundaryVectors[0]) * totalShadowExtension);
+		for (int j = 1; j < 4; j++)
+			bounds = rectExpand(bounds, maskVertices[j].position);
 
-		maskShape.setFillColor(sf::Color::Black);
+		for (int j = 0; j < _penumbraVertices.size(); j++)
+			bounds = rectExpand(bounds, _penumbraVertices[j].position);
 
-		antumbraTempTexture.draw(maskShape);
+		sf::IntRect region = LightSystem::getPixelRegion(antumbraTempTexture, view, bounds);
 
-		sf::VertexArray vertexArray;
+		if (region.width == 0 || region.height == 0)
+			continue;
 
-		vertexArray.setPrimitiveType(sf::PrimitiveType::Triangles);
+		LightSystem::clear(antumbraTempTexture, sf::Color::White, region);
 
-		vertexArray.resize(3);
+		antumbraTempTexture.setView(view);
+
+		antumbraTempTexture.draw(maskVertices, 4, sf::TrianglesFan);
 
 		{
 			sf::RenderStates states;
@@ -65,20 +79,8 @@ void LightDirectionEmission::render(const sf::View &view, sf::RenderTexture &lig
 			states.shader = &unshadowShader;
 
 			// Unmask with penumbras
-			for (int j = 0; j < penumbras.size(); j++) {
-				unshadowShader.setParameter("lightBrightness", penumbras[j]._lightBrightness);
-				unshadowShader.setParameter("darkBrightness", penumbras[j]._darkBrightness);
-
-				vertexArray[0].position = penumbras[j]._source;
-				vertexArray[1].position = penumbras[j]._source + vectorNormalize(penumbras[j]._lightEdge) * totalShadowExtension;
-				vertexArray[2].position = penumbras[j]._source + vectorNormalize(penumbras[j]._darkEdge) * totalShadowExtension;
-
-				vertexArray[0].texCoords = sf::Vector2f(0.0f, 1.0f);
-				vertexArray[1].texCoords = sf::Vector2f(1.0f, 0.0f);
-				vertexArray[2].texCoords = sf::Vector2f(0.0f, 0.0f);
-
-				antumbraTempTexture.draw(vertexArray, states);
-			}
+			if (!_penumbraVertices.empty())
+				antumbraTempTexture.draw(&_penumbraVertices[0], _penumbraVertices.size(), sf::Triangles, states);
 		}
 
 		antumbraTempTexture.display();
@@ -87,15 +89,7 @@ void LightDirectionEmission::render(const sf::View &view, sf::RenderTexture &lig
 		sf::RenderStates antumbraRenderStates;
 		antumbraRenderStates.blendMode = sf::BlendMultiply;
 
-		sf::Sprite s;
-
-		s.setTexture(antumbraTempTexture.getTexture());
-
-		lightTempTexture.setView(lightTempTexture.getDefaultView());
-
-		lightTempTexture.draw(s, antumbraRenderStates);
-
-		lightTempTexture.setView(view);
+		LightSystem::drawRegion(lightTempTexture, antumbraTempTexture.getTexture(), region, antumbraRenderStates);
 	}
 
 	for (int i = 0; i < shapes.size(); i++) {
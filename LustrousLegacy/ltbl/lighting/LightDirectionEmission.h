@@ -6,6 +6,9 @@
 namespace ltbl {
 	class LightDirectionEmission {
 	private:
+		// Penumbra triangles of the shape being rendered, reused between shapes
+		std::vector<sf::Vertex> _penumbraVertices;
+
 	public:
 		sf::Sprite _emissionSprite;
 		sf::Vector2f _castDirection;
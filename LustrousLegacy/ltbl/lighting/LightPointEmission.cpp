@@ -4,200 +4,256 @@
 
 #include <ltbl/lighting/LightSystem.h>
 
+#include <algorithm>
 #include <iostream>
 
 #include <assert.h>
 
 using namespace ltbl;
 
-void LightPointEmission::render(const sf::View &view, sf::RenderTexture &lightTempTexture, sf::RenderTexture &emissionTempTexture, sf::RenderTexture &antumbraTempTexture, const std::vector<QuadtreeOccupant*> &shapes, sf::Shader &unshadowShader, sf::Shader &lightOverShapeShader) {
-	LightSystem::clear(emissionTempTexture, sf::Color::Black);
-
-	emissionTempTexture.setView(view);
-
-	emissionTempTexture.draw(_emissionSprite);
-
-	emissionTempTexture.display();
-	
-	LightSystem::clear(lightTempTexture, sf::Color::Black);
-
-	lightTempTexture.setView(view);
+namespace {
+	// Adds the convex quad a, b, c, d as two black triangles
+	void appendMaskQuad(std::vector<sf::Vertex> &vertices, const sf::Vector2f &a, const sf::Vector2f &b, const sf::Vector2f &c, const sf::Vector2f &d) {
+		vertices.push_back(sf::Vertex(a, sf::Color::Black));
+		vertices.push_back(sf::Vertex(b, sf::Color::Black));
+		vertices.push_back(sf::Vertex(c, sf::Color::Black));
 
-	lightTempTexture.draw(_emissionSprite);
+		vertices.push_back(sf::Vertex(a, sf::Color::Black));
+		vertices.push_back(sf::Vertex(c, sf::Color::Black));
+		vertices.push_back(sf::Vertex(d, sf::Color::Black));
+	}
+}
 
+size_t LightPointEmission::updateShadowRevision(sf::Vector2f &castCenter, float &shadowExtension) {
 	sf::Transform t;
 	t.translate(_emissionSprite.getPosition());
 	t.rotate(_emissionSprite.getRotation());
 	t.scale(_emissionSprite.getScale());
 
-	sf::Vector2f castCenter = t.transformPoint(_localCastCenter);
+	castCenter = t.transformPoint(_localCastCenter);
 
-	float shadowExtension = _shadowOverExtendMultiplier * (getAABB().width + getAABB().height);
+	shadowExtension = _shadowOverExtendMultiplier * (getQuadtreeAABB().width + getQuadtreeAABB().height);
 
-	struct OuterEdges {
-		std::vector<int> _outerBoundaryIndices;
-		std::vector<sf::Vector2f> _outerBoundaryVectors;
-	};
+	if (castCenter != _shadowCastCenter || _sourceRadius != _shadowSourceRadius || shadowExtension != _shadowExtension) {
+		_shadowCastCenter = castCenter;
+		_shadowSourceRadius = _sourceRadius;
+		_shadowExtension = shadowExtension;
 
-	std::vector<OuterEdges> outerEdges(shapes.size());
+		_shadowRevision++;
+	}
+
+	return _shadowRevision;
+}
+
+bool LightPointEmission::updateBakeState(const std::vector<QuadtreeOccupant*> &shapes) {
+	sf::Vector2f castCenter;
+	float shadowExtension;
+
+	size_t lightRevision = updateShadowRevision(castCenter, shadowExtension);
+
+	_currentBakeShapes.clear();
 
-	// Mask off light shape (over-masking - mask too much, reveal penumbra/antumbra afterwards)
 	for (int i = 0; i < shapes.size(); i++) {
 		LightShape* pLightShape = static_cast<LightShape*>(shapes[i]);
 
-		// Get boundaries
-		std::vector<int> innerBoundaryIndices;
-		std::vector<sf::Vector2f> innerBoundaryVectors;
-		std::vector<LightSystem::Penumbra> penumbras;
+		_currentBakeShapes.push_back(std::make_pair(pLightShape, pLightShape->getShadowRevision()));
+	}
 
-		LightSystem::getPenumbrasPoint(penumbras, innerBoundaryIndices, innerBoundaryVectors, outerEdges[i]._outerBoundaryIndices, outerEdges[i]._outerBoundaryVectors, pLightShape->_shape, castCenter, _sourceRadius);
+	// Query order changes with the quadtree, so compare the shapes in pointer order
+	std::sort(_currentBakeShapes.begin(), _currentBakeShapes.end());
 
-		if (innerBoundaryIndices.size() != 2 || outerEdges[i]._outerBoundaryIndices.size() != 2)
-			continue;
+	bool unchanged = lightRevision == _bakeLightRevision && getQuadtreeAABB() == _bakeRegion &&
+		_emissionSprite.getRotation() == _bakeRotation && _currentBakeShapes == _bakeShapes;
 
-		// Render shape
-		if (!pLightShape->_renderLightOverShape) {
-			pLightShape->_shape.setFillColor(sf::Color::Black);
+	if (!unchanged) {
+		_bakeLightRevision = lightRevision;
+		_bakeRegion = getQuadtreeAABB();
+		_bakeRotation = _emissionSprite.getRotation();
 
-			lightTempTexture.draw(pLightShape->_shape);
-		}
+		_bakeShapes.swap(_currentBakeShapes);
 
-		sf::RenderStates maskRenderStates;
-		maskRenderStates.blendMode = sf::BlendNone;
+		_baked = false;
+	}
 
-		sf::Vector2f as = pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(outerEdges[i]._outerBoundaryIndices[0]));
-		sf::Vector2f bs = pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(outerEdges[i]._outerBoundaryIndices[1]));
-		sf::Vector2f ad = outerEdges[i]._outerBoundaryVectors[0];
-		sf::Vector2f bd = outerEdges[i]._outerBoundaryVectors[1];
+	return unchanged;
+}
 
-		sf::Vector2f intersectionOuter;
+void LightPointEmission::updateShadowCache(ShadowCache &cache, LightShape &lightShape, const sf::Vector2f &castCenter, float shadowExtension) {
+	std::vector<int> innerBoundaryIndices;
+	std::vector<sf::Vector2f> innerBoundaryVectors;
+	std::vector<int> outerBoundaryIndices;
+	std::vector<sf::Vector2f> outerBoundaryVectors;
+	std::vector<LightSystem::Penumbra> penumbras;
 
-		// Handle antumbras as a seperate case
-		if (rayIntersect(as, ad, bs, bd, intersectionOuter)) {
-			sf::Vector2f asi = pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(innerBoundaryIndices[0]));
-			sf::Vector2f bsi = pLightShape->_shape.getTransform().transformPoint(pLightShape->_shape.getPoint(innerBoundaryIndices[1]));
-			sf::Vector2f adi = innerBoundaryVectors[0];
-			sf::Vector2f bdi = innerBoundaryVectors[1];
+	const ShadowCaster &caster = lightShape.getShadowCaster();
 
-			LightSystem::clear(antumbraTempTexture, sf::Color::White);
+	LightSystem::getPenumbrasPoint(penumbras, innerBoundaryIndices, innerBoundaryVectors, outerBoundaryIndices, outerBoundaryVectors, caster, castCenter, _sourceRadius);
 
-			antumbraTempTexture.setView(view);
+	cache._maskVertices.clear();
+	cache._penumbraVertices.clear();
 
-			sf::Vector2f intersectionInner;
+	cache._castsShadow = innerBoundaryIndices.size() == 2 && outerBoundaryIndices.size() == 2;
 
-			if (rayIntersect(asi, adi, bsi, bdi, intersectionInner)) {
-				sf::ConvexShape maskShape;
+	if (!cache._castsShadow)
+		return;
 
-				maskShape.setPointCount(3);
+	sf::Vector2f as = caster.getPoint(outerBoundaryIndices[0]);
+	sf::Vector2f bs = caster.getPoint(outerBoundaryIndices[1]);
+	sf::Vector2f ad = outerBoundaryVectors[0];
+	sf::Vector2f bd = outerBoundaryVectors[1];
 
-				maskShape.setPoint(0, asi);
-				maskShape.setPoint(1, bsi);
-				maskShape.setPoint(2, intersectionInner);
+	sf::Vector2f intersectionOuter;
 
-				maskShape.setFillColor(sf::Color::Black);
+	cache._antumbra = rayIntersect(as, ad, bs, bd, intersectionOuter);
 
-				antumbraTempTexture.draw(maskShape);	
-			}
-			else {
-				sf::ConvexShape maskShape;
+	if (cache._antumbra) {
+		// Mask with the inner boundaries, the penumbras add the light back
+		sf::Vector2f asi = caster.getPoint(innerBoundaryIndices[0]);
+		sf::Vector2f bsi = caster.getPoint(innerBoundaryIndices[1]);
+		sf::Vector2f adi = innerBoundaryVectors[0];
+		sf::Vector2f bdi = innerBoundaryVectors[1];
 
-				maskShape.setPointCount(4);
+		sf::Vector2f intersectionInner;
 
-				maskShape.setPoint(0, asi);
-				maskShape.setPoint(1, bsi);
-				maskShape.setPoint(2, bsi + vectorNormalize(bdi) * shadowExtension);
-				maskShape.setPoint(3, asi + vectorNormalize(adi) * shadowExtension);
+		if (rayIntersect(asi, adi, bsi, bdi, intersectionInner)) {
+			cache._maskVertices.push_back(sf::Vertex(asi, sf::Color::Black));
+			cache._maskVertices.push_back(sf::Vertex(bsi, sf::Color::Black));
+			cache._maskVertices.push_back(sf::Vertex(intersectionInner, sf::Color::Black));
+		}
+		else
+			appendMaskQuad(cache._maskVertices, asi, bsi, bsi + vectorNormalize(bdi) * shadowExtension, asi + vectorNormalize(adi) * shadowExtension);
+	}
+	else
+		appendMaskQuad(cache._maskVertices, as, bs, bs + vectorNormalize(bd) * shadowExtension, as + vectorNormalize(ad) * shadowExtension);
 
-				maskShape.setFillColor(sf::Color::Black);
+	for (int j = 0; j < penumbras.size(); j++)
+		LightSystem::appendPenumbra(cache._penumbraVertices, penumbras[j], shadowExtension);
 
-				antumbraTempTexture.draw(maskShape);
-			}
+	cache._bounds = rectFromBounds(cache._maskVertices[0].position, cache._maskVertices[0].position);
 
-			// Add light back for antumbra/penumbras
-			sf::VertexArray vertexArray;
+	for (int j = 1; j < cache._maskVertices.size(); j++)
+		cache._bounds = rectExpand(cache._bounds, cache._maskVertices[j].position);
 
-			vertexArray.setPrimitiveType(sf::PrimitiveType::Triangles);
+	for (int j = 0; j < cache._penumbraVertices.size(); j++)
+		cache._bounds = rectExpand(cache._bounds, cache._penumbraVertices[j].position);
+}
 
-			vertexArray.resize(3);
+void LightPointEmission::render(const sf::View &view, sf::RenderTexture &lightTempTexture, sf::RenderTexture &emissionTempTexture, sf::RenderTexture &antumbraTempTexture, const std::vector<QuadtreeOccupant*> &shapes, sf::Shader &unshadowShader, sf::Shader &lightOverShapeShader) {
+	// Pixels this light is rendered to
+	sf::IntRect region = lightTempTexture.getViewport(view);
 
-			sf::RenderStates penumbraRenderStates;
-			penumbraRenderStates.blendMode = sf::BlendAdd;
-			penumbraRenderStates.shader = &unshadowShader;
+	LightSystem::clear(emissionTempTexture, sf::Color::Black, region);
 
-			// Unmask with penumbras
-			for (int j = 0; j < penumbras.size(); j++) {
-				unshadowShader.setParameter("lightBrightness", penumbras[j]._lightBrightness);
-				unshadowShader.setParameter("darkBrightness", penumbras[j]._darkBrightness);
+	emissionTempTexture.setView(view);
 
-				vertexArray[0].position = penumbras[j]._source;
-				vertexArray[1].position = penumbras[j]._source + vectorNormalize(penumbras[j]._lightEdge) * shadowExtension;
-				vertexArray[2].position = penumbras[j]._source + vectorNormalize(penumbras[j]._darkEdge) * shadowExtension;
+	emissionTempTexture.draw(_emissionSprite);
 
-				vertexArray[0].texCoords = sf::Vector2f(0.0f, 1.0f);
-				vertexArray[1].texCoords = sf::Vector2f(1.0f, 0.0f);
-				vertexArray[2].texCoords = sf::Vector2f(0.0f, 0.0f);
+	emissionTempTexture.display();
+	
+	LightSystem::clear(lightTempTexture, sf::Color::Black, region);
 
-				antumbraTempTexture.draw(vertexArray, penumbraRenderStates);
-			}
+	lightTempTexture.setView(view);
 
-			antumbraTempTexture.display();
+	lightTempTexture.draw(_emissionSprite);
 
-			// Multiply back to lightTempTexture
-			sf::RenderStates antumbraRenderStates;
-			antumbraRenderStates.blendMode = sf::BlendMultiply;
+	sf::Vector2f castCenter;
+	float shadowExtension;
 
-			sf::Sprite s;
+	// Shadow geometry of all shapes changes with the light, the shapes are checked one by one below
+	updateShadowRevision(castCenter, shadowExtension);
 
-			s.setTexture(antumbraTempTexture.getTexture());
+	_shadowFrame++;
 
-			lightTempTexture.setView(lightTempTexture.getDefaultView());
+	_maskBatch.clear();
+	_penumbraBatch.clear();
 
-			lightTempTexture.draw(s, antumbraRenderStates);
+	// Mask off light shape (over-masking - mask too much, reveal penumbra/antumbra afterwards)
+	for (int i = 0; i < shapes.size(); i++) {
+		LightShape* pLightShape = static_cast<LightShape*>(shapes[i]);
 
-			lightTempTexture.setView(view);
+		size_t shapeRevision = pLightShape->getShadowRevision();
+
+		std::pair<std::unordered_map<const LightShape*, ShadowCache>::iterator, bool> inserted = _shadowCaches.insert(std::make_pair(pLightShape, ShadowCache()));
+
+		ShadowCache &cache = inserted.first->second;
+
+		// Recompute the geometry only if the light or the shape changed since it was cached
+		if (inserted.second || cache._lightRevision != _shadowRevision || cache._shapeRevision != shapeRevision) {
+			updateShadowCache(cache, *pLightShape, castCenter, shadowExtension);
+
+			cache._lightRevision = _shadowRevision;
+			cache._shapeRevision = shapeRevision;
 		}
-		else {
-			sf::ConvexShape maskShape;
 
-			maskShape.setPointCount(4);
+		cache._frame = _shadowFrame;
+
+		if (!cache._castsShadow)
+			continue;
+
+		// Render shape
+		if (!pLightShape->_renderLightOverShape) {
+			pLightShape->_shape.setFillColor(sf::Color::Black);
 
-			maskShape.setPoint(0, as);
-			maskShape.setPoint(1, bs);
-			maskShape.setPoint(2, bs + vectorNormalize(bd) * shadowExtension);
-			maskShape.setPoint(3, as + vectorNormalize(ad) * shadowExtension);
+			lightTempTexture.draw(pLightShape->_shape);
+		}
 
-			maskShape.setFillColor(sf::Color::Black);
+		// Handle antumbras as a seperate case
+		if (cache._antumbra) {
+			// Only the pixels of the light the shadow reaches
+			sf::IntRect antumbraRegion;
 
-			lightTempTexture.draw(maskShape);
+			if (!region.intersects(LightSystem::getPixelRegion(antumbraTempTexture, view, cache._bounds), antumbraRegion))
+				continue;
 
-			sf::VertexArray vertexArray;
+			LightSystem::clear(antumbraTempTexture, sf::Color::White, antumbraRegion);
 
-			vertexArray.setPrimitiveType(sf::PrimitiveType::Triangles);
+			antumbraTempTexture.setView(view);
 
-			vertexArray.resize(3);
+			antumbraTempTexture.draw(&cache._maskVertices[0], cache._maskVertices.size(), sf::Triangles);
 
+			// Add light back for antumbra/penumbras
 			sf::RenderStates penumbraRenderStates;
-			penumbraRenderStates.blendMode = sf::BlendMultiply;
+			penumbraRenderStates.blendMode = sf::BlendAdd;
 			penumbraRenderStates.shader = &unshadowShader;
 
 			// Unmask with penumbras
-			for (int j = 0; j < penumbras.size(); j++) {
-				unshadowShader.setParameter("lightBrightness", penumbras[j]._lightBrightness);
-				unshadowShader.setParameter("darkBrightness", penumbras[j]._darkBrightness);
+			if (!cache._penumbraVertices.empty())
+				antumbraTempTexture.draw(&cache._penumbraVertices[0], cache._penumbraVertices.size(), sf::Triangles, penumbraRenderStates);
 
-				vertexArray[0].position = penumbras[j]._source;
-				vertexArray[1].position = penumbras[j]._source + vectorNormalize(penumbras[j]._lightEdge) * shadowExtension;
-				vertexArray[2].position = penumbras[j]._source + vectorNormalize(penumbras[j]._darkEdge) * shadowExtension;
+			antumbraTempTexture.display();
 
-				vertexArray[0].texCoords = sf::Vector2f(0.0f, 1.0f);
-				vertexArray[1].texCoords = sf::Vector2f(1.0f, 0.0f);
-				vertexArray[2].texCoords = sf::Vector2f(0.0f, 0.0f);
+			// Multiply back to lightTempTexture
+			sf::RenderStates antumbraRenderStates;
+			antumbraRenderStates.blendMode = sf::BlendMultiply;
 
-				lightTempTexture.draw(vertexArray, penumbraRenderStates);
-			}
+			LightSystem::drawRegion(lightTempTexture, antumbraTempTexture.getTexture(), antumbraRegion, antumbraRenderStates);
+		}
+		else {
+			// Masks only darken and penumbras only multiply, so the order across shapes does not matter
+			_maskBatch.insert(_maskBatch.end(), cache._maskVertices.begin(), cache._maskVertices.end());
+			_penumbraBatch.insert(_penumbraBatch.end(), cache._penumbraVertices.begin(), cache._penumbraVertices.end());
 		}
 	}
 
+	if (!_maskBatch.empty())
+		lightTempTexture.draw(&_maskBatch[0], _maskBatch.size(), sf::Triangles);
+
+	if (!_penumbraBatch.empty()) {
+		sf::RenderStates penumbraRenderStates;
+		penumbraRenderStates.blendMode = sf::BlendMultiply;
+		penumbraRenderStates.shader = &unshadowShader;
+
+		// Unmask with penumbras
+		lightTempTexture.draw(&_penumbraBatch[0], _penumbraBatch.size(), sf::Triangles, penumbraRenderStates);
+	}
+
+	// Drop the geometry of shapes this light no longer reaches
+	for (std::unordered_map<const LightShape*, ShadowCache>::iterator it = _shadowCaches.begin(); it != _shadowCaches.end();)
+	if (it->second._frame != _shadowFrame)
+		it = _shadowCaches.erase(it);
+	else
+		it++;
+
 	for (int i = 0; i < shapes.size(); i++) {
 		LightShape* pLightShape = static_cast<LightShape*>(shapes[i]);
 
@@ -2,9 +2,75 @@
 
 #include <ltbl/quadtree/QuadtreeOccupant.h>
 
+#include <unordered_map>
+#include <memory>
+
 namespace ltbl {
+	class LightShape;
+
 	class LightPointEmission : public QuadtreeOccupant {
 	private:
+		// Shadow geometry of one shape under this light, in world space
+		struct ShadowCache {
+			// Revisions the geometry was computed at
+			size_t _lightRevision;
+			size_t _shapeRevision;
+
+			// Render call that last used the entry, entries not used by the latest call are dropped
+			size_t _frame;
+
+			// False if the shape does not cast a shadow (no boundaries found)
+			bool _castsShadow;
+
+			// If set, the mask is drawn to the antumbra texture, else straight onto the light
+			bool _antumbra;
+
+			// Triangles masking off the shadow
+			std::vector<sf::Vertex> _maskVertices;
+
+			// Triangles of the penumbras, see LightSystem::appendPenumbra
+			std::vector<sf::Vertex> _penumbraVertices;
+
+			// World bounds of the mask and penumbras
+			sf::FloatRect _bounds;
+		};
+
+		std::unordered_map<const LightShape*, ShadowCache> _shadowCaches;
+
+		size_t _shadowRevision;
+		size_t _shadowFrame;
+
+		// Masks and penumbras of the shapes without antumbras, drawn in one batch each
+		std::vector<sf::Vertex> _maskBatch;
+		std::vector<sf::Vertex> _penumbraBatch;
+
+		// What the shadow geometry of this light depends on, at the current revision
+		sf::Vector2f _shadowCastCenter;
+		float _shadowSourceRadius;
+		float _shadowExtension;
+
+		// Lightmap of a static light, covering _bakedRegion at _bakedPixelDensity texels per world unit
+		std::unique_ptr<sf::RenderTexture> _pBakedTexture;
+		sf::FloatRect _bakedRegion;
+		sf::Vector2f _bakedPixelDensity;
+		bool _baked;
+
+		// State of the light and its shapes (sorted by pointer) at the last updateBakeState
+		size_t _bakeLightRevision;
+		sf::FloatRect _bakeRegion;
+		float _bakeRotation;
+		std::vector<std::pair<const LightShape*, size_t>> _bakeShapes;
+		std::vector<std::pair<const LightShape*, size_t>> _currentBakeShapes;
+
+		// Takes a new shadow revision if the cast center, source radius or shadow extension changed
+		size_t updateShadowRevision(sf::Vector2f &castCenter, float &shadowExtension);
+
+		void updateShadowCache(ShadowCache &cache, LightShape &lightShape, const sf::Vector2f &castCenter, float shadowExtension);
+
+		// Returns true if neither the light nor the given shapes changed since the last call,
+		// otherwise the lightmap is invalidated
+		bool updateBakeState(const std::vector<QuadtreeOccupant*> &shapes);
+
 	public:
 		sf::Sprite _emissionSprite;
 		sf::Vector2f _localCastCenter;
@@ -13,14 +79,47 @@ namespace ltbl {
 
 		float _shadowOverExtendMultiplier;
 
+		// Static lights are rendered once into a lightmap covering their AABB, which is reused for as
+		// long as neither the light nor any shape it reaches changes. The lightmap has the pixel
+		// density of the view it was baked for and is baked again when the view zooms. A light larger
+		// than the render target is baked at a lower density. With a rotated view the lightmap is
+		// resampled when drawn, so it is slightly softer than the live light
+		bool _static;
+
 		LightPointEmission()
-			: _localCastCenter(0.0f, 0.0f), _sourceRadius(8.0f), _shadowOverExtendMultiplier(1.4f)
+			: _shadowRevision(0), _shadowFrame(0),
+			_shadowCastCenter(0.0f, 0.0f), _shadowSourceRadius(0.0f), _shadowExtension(0.0f),
+			_bakedPixelDensity(0.0f, 0.0f), _baked(false), _bakeLightRevision(0), _bakeRotation(0.0f),
+			_localCastCenter(0.0f, 0.0f), _sourceRadius(8.0f), _shadowOverExtendMultiplier(1.4f),
+			_static(false)
 		{}
 
 		sf::FloatRect getAABB() const {
 			return _emissionSprite.getGlobalBounds();
 		}
 
+		// Drops the cached shadow geometry of all shapes
+		void clearShadowCaches() {
+			_shadowCaches.clear();
+		}
+
+		size_t getNumShadowCaches() const {
+			return _shadowCaches.size();
+		}
+
+		// Rebakes the lightmap of a static light. Moves are picked up automatically, call this
+		// after changing the color or texture of _emissionSprite
+		void invalidateBake() {
+			_baked = false;
+		}
+
+		bool baked() const {
+			return _baked;
+		}
+
+		// Only draws to the viewport of view, so the pixels outside of it in the textures are left as they were
 		void render(const sf::View &view, sf::RenderTexture &lightTempTexture, sf::RenderTexture &emissionTempTexture, sf::RenderTexture &antumbraTempTexture, const std::vector<QuadtreeOccupant*> &shapes, sf::Shader &unshadowShader, sf::Shader &lightOverShapeShader);
+
+		friend class LightSystem;
 	};
 }
\ No newline at end of file
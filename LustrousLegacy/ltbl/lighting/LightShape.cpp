@@ -1,3 +1,66 @@
 #include <ltbl/lighting/LightShape.h>
 
 using namespace ltbl;
+
+void ShadowCaster::set(const sf::ConvexShape &shape) {
+	size_t numPoints = shape.getPointCount();
+
+	_x.resize(numPoints + 1);
+	_y.resize(numPoints + 1);
+	_normalX.resize(numPoints);
+	_normalY.resize(numPoints);
+
+	const sf::Transform &transform = shape.getTransform();
+
+	for (size_t i = 0; i < numPoints; i++) {
+		sf::Vector2f point = transform.transformPoint(shape.getPoint(i));
+
+		_x[i] = point.x;
+		_y[i] = point.y;
+	}
+
+	if (numPoints == 0)
+		return;
+
+	_x[numPoints] = _x[0];
+	_y[numPoints] = _y[0];
+
+	for (size_t i = 0; i < numPoints; i++) {
+		sf::Vector2f pointToNextPoint(_x[i + 1] - _x[i], _y[i + 1] - _y[i]);
+
+		sf::Vector2f normal = vectorNormalize(sf::Vector2f(-pointToNextPoint.y, pointToNextPoint.x));
+
+		_normalX[i] = normal.x;
+		_normalY[i] = normal.y;
+	}
+}
+
+size_t LightShape::_nextShadowRevision = 0;
+
+size_t LightShape::getShadowRevision() {
+	if (_shape.getPosition() != _shadowPosition || _shape.getRotation() != _shadowRotation ||
+		_shape.getScale() != _shadowScale || _shape.getOrigin() != _shadowOrigin ||
+		_shape.getPointCount() != _shadowPointCount) {
+		_shadowPosition = _shape.getPosition();
+		_shadowRotation = _shape.getRotation();
+		_shadowScale = _shape.getScale();
+		_shadowOrigin = _shape.getOrigin();
+		_shadowPointCount = _shape.getPointCount();
+
+		markShadowDirty();
+	}
+
+	return _shadowRevision;
+}
+
+const ShadowCaster &LightShape::getShadowCaster() {
+	size_t revision = getShadowRevision();
+
+	if (revision != _shadowCasterRevision) {
+		_shadowCaster.set(_shape);
+
+		_shadowCasterRevision = revision;
+	}
+
+	return _shadowCaster;
+}
\ No newline at end of file
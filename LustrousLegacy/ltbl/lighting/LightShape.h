@@ -3,18 +3,71 @@
 #include <ltbl/quadtree/QuadtreeOccupant.h>
 
 namespace ltbl {
+	// World space polygon of a LightShape as the shadow computations use it. Coordinates are
+	// kept in separate arrays so the edges can be processed 4 at a time
+	struct ShadowCaster {
+		// Vertices, followed by a copy of the first so edge i always runs from i to i + 1
+		std::vector<float> _x, _y;
+
+		// Unit normals of the edges
+		std::vector<float> _normalX, _normalY;
+
+		void set(const sf::ConvexShape &shape);
+
+		size_t getPointCount() const {
+			return _normalX.size();
+		}
+
+		sf::Vector2f getPoint(size_t index) const {
+			return sf::Vector2f(_x[index], _y[index]);
+		}
+	};
+
 	class LightShape : public QuadtreeOccupant {
+	private:
+		// Revision of the shadow geometry. Revisions are unique across all shapes, so shadow
+		// caches keyed by shape pointer can not mistake a new shape for a deleted one
+		size_t _shadowRevision;
+
+		// Transform of _shape when the revision was taken
+		sf::Vector2f _shadowPosition;
+		sf::Vector2f _shadowScale;
+		sf::Vector2f _shadowOrigin;
+		float _shadowRotation;
+		size_t _shadowPointCount;
+
+		// Caster of _shape, at _shadowCasterRevision
+		ShadowCaster _shadowCaster;
+		size_t _shadowCasterRevision;
+
+		static size_t _nextShadowRevision;
+
 	public:
 		bool _renderLightOverShape;
 
 		sf::ConvexShape _shape;
 
 		LightShape()
-			: _renderLightOverShape(true)
+			: _shadowRevision(_nextShadowRevision++),
+			_shadowPosition(0.0f, 0.0f), _shadowScale(1.0f, 1.0f), _shadowOrigin(0.0f, 0.0f), _shadowRotation(0.0f), _shadowPointCount(0),
+			_shadowCasterRevision(static_cast<size_t>(-1)),
+			_renderLightOverShape(true)
 		{}
 
 		sf::FloatRect getAABB() const {
 			return _shape.getGlobalBounds();
 		}
+
+		// Changes of the position, rotation, scale, origin or point count of _shape are picked up
+		// automatically. Call this after moving points of _shape to recompute its shadows
+		void markShadowDirty() {
+			_shadowRevision = _nextShadowRevision++;
+		}
+
+		// Takes a new revision if _shape was transformed since the last call
+		size_t getShadowRevision();
+
+		// Rebuilt only when the shadow revision changes, so once for shapes that never move
+		const ShadowCaster &getShadowCaster();
 	};
 }
\ No newline at end of file
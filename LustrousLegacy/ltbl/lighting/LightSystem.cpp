@@ -4,71 +4,186 @@
 
 #include <iostream>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define LTBL_SSE
+#include <xmmintrin.h>
+#endif
+
 using namespace ltbl;
 
-void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vector<int> &innerBoundaryIndices, std::vector<sf::Vector2f> &innerBoundaryVectors, std::vector<int> &outerBoundaryIndices, std::vector<sf::Vector2f> &outerBoundaryVectors, const sf::ConvexShape &shape, const sf::Vector2f &sourceCenter, float sourceRadius) {
-	const int numPoints = shape.getPointCount();
+namespace {
+	// An edge faces the light if a ray from either side of the source reaches either end of it
+	// from the front. Both edges: both rays of one end do. One edge: any ray does
+	void setFacing(std::vector<char> &facingFrontBothEdges, std::vector<char> &facingFrontOneEdge, int edge,
+		const sf::Vector2f &firstEdgeRay, const sf::Vector2f &secondEdgeRay, const sf::Vector2f &firstNextEdgeRay, const sf::Vector2f &secondNextEdgeRay, const sf::Vector2f &normal)
+	{
+		facingFrontBothEdges[edge] = (vectorDot(firstEdgeRay, normal) > 0.0f && vectorDot(secondEdgeRay, normal) > 0.0f) || vectorDot(firstNextEdgeRay, normal) > 0.0f && vectorDot(secondNextEdgeRay, normal) > 0.0f;
+		facingFrontOneEdge[edge] = (vectorDot(firstEdgeRay, normal) > 0.0f || vectorDot(secondEdgeRay, normal) > 0.0f) || vectorDot(firstNextEdgeRay, normal) > 0.0f || vectorDot(secondNextEdgeRay, normal) > 0.0f;
+	}
 
-	std::vector<bool> bothEdgesBoundaryWindings;
-	bothEdgesBoundaryWindings.reserve(2);
+#ifdef LTBL_SSE
+	// vectorNormalize of 4 vectors, with the same operations so the results match exactly
+	void normalize4(__m128 &x, __m128 &y) {
+		__m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+		__m128 isZero = _mm_cmpeq_ps(magnitude, _mm_setzero_ps());
+		__m128 distInv = _mm_div_ps(_mm_set1_ps(1.0f), magnitude);
 
-	std::vector<bool> oneEdgeBoundaryWindings;
-	oneEdgeBoundaryWindings.reserve(2);
+		x = _mm_or_ps(_mm_and_ps(isZero, _mm_set1_ps(1.0f)), _mm_andnot_ps(isZero, _mm_mul_ps(x, distInv)));
+		y = _mm_andnot_ps(isZero, _mm_mul_ps(y, distInv));
+	}
 
-	// Calculate front and back facing sides
-	std::vector<bool> facingFrontBothEdges;
-	facingFrontBothEdges.reserve(numPoints);
+	__m128 dot4(__m128 x, __m128 y, __m128 normalX, __m128 normalY) {
+		return _mm_add_ps(_mm_mul_ps(x, normalX), _mm_mul_ps(y, normalY));
+	}
 
-	std::vector<bool> facingFrontOneEdge;
-	facingFrontOneEdge.reserve(numPoints);
+	void setFacing4(std::vector<char> &facingFrontBothEdges, std::vector<char> &facingFrontOneEdge, int edge,
+		__m128 firstDot, __m128 secondDot, __m128 firstNextDot, __m128 secondNextDot)
+	{
+		__m128 zero = _mm_setzero_ps();
 
-	for (int i = 0; i < numPoints; i++) {
-		sf::Vector2f point = shape.getTransform().transformPoint(shape.getPoint(i));
+		__m128 first = _mm_cmpgt_ps(firstDot, zero);
+		__m128 second = _mm_cmpgt_ps(secondDot, zero);
+		__m128 firstNext = _mm_cmpgt_ps(firstNextDot, zero);
+		__m128 secondNext = _mm_cmpgt_ps(secondNextDot, zero);
 
-		sf::Vector2f nextPoint;
+		int bothEdges = _mm_movemask_ps(_mm_or_ps(_mm_and_ps(first, second), _mm_and_ps(firstNext, secondNext)));
+		int oneEdge = _mm_movemask_ps(_mm_or_ps(_mm_or_ps(first, second), _mm_or_ps(firstNext, secondNext)));
 
-		if (i < numPoints - 1)
-			nextPoint = shape.getTransform().transformPoint(shape.getPoint(i + 1));
-		else
-			nextPoint = shape.getTransform().transformPoint(shape.getPoint(0));
+		for (int lane = 0; lane < 4; lane++) {
+			facingFrontBothEdges[edge + lane] = (bothEdges >> lane) & 1;
+			facingFrontOneEdge[edge + lane] = (oneEdge >> lane) & 1;
+		}
+	}
+#endif
 
-		sf::Vector2f firstEdgeRay;
-		sf::Vector2f secondEdgeRay;
-		sf::Vector2f firstNextEdgeRay;
-		sf::Vector2f secondNextEdgeRay;
+	void getFacingPoint(std::vector<char> &facingFrontBothEdges, std::vector<char> &facingFrontOneEdge, const ShadowCaster &caster, const sf::Vector2f &sourceCenter, float sourceRadius) {
+		const int numPoints = caster.getPointCount();
 
-		{
-			sf::Vector2f sourceToPoint = point - sourceCenter;
+		int i = 0;
+
+#ifdef LTBL_SSE
+		__m128 centerX = _mm_set1_ps(sourceCenter.x);
+		__m128 centerY = _mm_set1_ps(sourceCenter.y);
+		__m128 radius = _mm_set1_ps(sourceRadius);
+
+		for (; i + 4 <= numPoints; i += 4) {
+			__m128 pointX = _mm_loadu_ps(&caster._x[i]);
+			__m128 pointY = _mm_loadu_ps(&caster._y[i]);
+			__m128 nextPointX = _mm_loadu_ps(&caster._x[i + 1]);
+			__m128 nextPointY = _mm_loadu_ps(&caster._y[i + 1]);
+
+			__m128 normalX = _mm_loadu_ps(&caster._normalX[i]);
+			__m128 normalY = _mm_loadu_ps(&caster._normalY[i]);
 
-			sf::Vector2f perpendicularOffset(-sourceToPoint.y, sourceToPoint.x);
+			// Offsets perpendicular to the direction from the source to each end, source radius long
+			__m128 offsetX = _mm_sub_ps(centerY, pointY);
+			__m128 offsetY = _mm_sub_ps(pointX, centerX);
+			__m128 nextOffsetX = _mm_sub_ps(centerY, nextPointY);
+			__m128 nextOffsetY = _mm_sub_ps(nextPointX, centerX);
 
-			perpendicularOffset = vectorNormalize(perpendicularOffset);
-			perpendicularOffset *= sourceRadius;
+			normalize4(offsetX, offsetY);
+			normalize4(nextOffsetX, nextOffsetY);
 
-			firstEdgeRay = point - (sourceCenter - perpendicularOffset);
-			secondEdgeRay = point - (sourceCenter + perpendicularOffset);
+			offsetX = _mm_mul_ps(offsetX, radius);
+			offsetY = _mm_mul_ps(offsetY, radius);
+			nextOffsetX = _mm_mul_ps(nextOffsetX, radius);
+			nextOffsetY = _mm_mul_ps(nextOffsetY, radius);
+
+			__m128 firstDot = dot4(_mm_sub_ps(pointX, _mm_sub_ps(centerX, offsetX)), _mm_sub_ps(pointY, _mm_sub_ps(centerY, offsetY)), normalX, normalY);
+			__m128 secondDot = dot4(_mm_sub_ps(pointX, _mm_add_ps(centerX, offsetX)), _mm_sub_ps(pointY, _mm_add_ps(centerY, offsetY)), normalX, normalY);
+			__m128 firstNextDot = dot4(_mm_sub_ps(nextPointX, _mm_sub_ps(centerX, nextOffsetX)), _mm_sub_ps(nextPointY, _mm_sub_ps(centerY, nextOffsetY)), normalX, normalY);
+			__m128 secondNextDot = dot4(_mm_sub_ps(nextPointX, _mm_add_ps(centerX, nextOffsetX)), _mm_sub_ps(nextPointY, _mm_add_ps(centerY, nextOffsetY)), normalX, normalY);
+
+			setFacing4(facingFrontBothEdges, facingFrontOneEdge, i, firstDot, secondDot, firstNextDot, secondNextDot);
+		}
+#endif
+
+		for (; i < numPoints; i++) {
+			sf::Vector2f point = caster.getPoint(i);
+			sf::Vector2f nextPoint = caster.getPoint(i + 1);
+
+			sf::Vector2f sourceToPoint = point - sourceCenter;
+			sf::Vector2f perpendicularOffset = vectorNormalize(sf::Vector2f(-sourceToPoint.y, sourceToPoint.x)) * sourceRadius;
+
+			sf::Vector2f sourceToNextPoint = nextPoint - sourceCenter;
+			sf::Vector2f nextPerpendicularOffset = vectorNormalize(sf::Vector2f(-sourceToNextPoint.y, sourceToNextPoint.x)) * sourceRadius;
+
+			setFacing(facingFrontBothEdges, facingFrontOneEdge, i,
+				point - (sourceCenter - perpendicularOffset), point - (sourceCenter + perpendicularOffset),
+				nextPoint - (sourceCenter - nextPerpendicularOffset), nextPoint - (sourceCenter + nextPerpendicularOffset),
+				sf::Vector2f(caster._normalX[i], caster._normalY[i]));
 		}
+	}
+
+	void getFacingDirection(std::vector<char> &facingFrontBothEdges, std::vector<char> &facingFrontOneEdge, const ShadowCaster &caster, const sf::Vector2f &sourceDirection, float sourceRadius, float sourceDistance) {
+		const int numPoints = caster.getPointCount();
+
+		sf::Vector2f perpendicularOffset = vectorNormalize(sf::Vector2f(-sourceDirection.y, sourceDirection.x)) * sourceRadius;
+		sf::Vector2f sourceOffset = sourceDirection * sourceDistance;
+
+		int i = 0;
+
+#ifdef LTBL_SSE
+		__m128 sourceOffsetX = _mm_set1_ps(sourceOffset.x);
+		__m128 sourceOffsetY = _mm_set1_ps(sourceOffset.y);
+		__m128 offsetX = _mm_set1_ps(perpendicularOffset.x);
+		__m128 offsetY = _mm_set1_ps(perpendicularOffset.y);
+
+		for (; i + 4 <= numPoints; i += 4) {
+			__m128 pointX = _mm_loadu_ps(&caster._x[i]);
+			__m128 pointY = _mm_loadu_ps(&caster._y[i]);
+			__m128 nextPointX = _mm_loadu_ps(&caster._x[i + 1]);
+			__m128 nextPointY = _mm_loadu_ps(&caster._y[i + 1]);
+
+			__m128 normalX = _mm_loadu_ps(&caster._normalX[i]);
+			__m128 normalY = _mm_loadu_ps(&caster._normalY[i]);
 
-		{
-			sf::Vector2f sourceToPoint = nextPoint - sourceCenter;
+			// Both sides of the source as seen from the start of each edge
+			__m128 sourceX = _mm_sub_ps(pointX, sourceOffsetX);
+			__m128 sourceY = _mm_sub_ps(pointY, sourceOffsetY);
 
-			sf::Vector2f perpendicularOffset(-sourceToPoint.y, sourceToPoint.x);
+			__m128 firstSourceX = _mm_sub_ps(sourceX, offsetX);
+			__m128 firstSourceY = _mm_sub_ps(sourceY, offsetY);
+			__m128 secondSourceX = _mm_add_ps(sourceX, offsetX);
+			__m128 secondSourceY = _mm_add_ps(sourceY, offsetY);
 
-			perpendicularOffset = vectorNormalize(perpendicularOffset);
-			perpendicularOffset *= sourceRadius;
+			__m128 firstDot = dot4(_mm_sub_ps(pointX, firstSourceX), _mm_sub_ps(pointY, firstSourceY), normalX, normalY);
+			__m128 secondDot = dot4(_mm_sub_ps(pointX, secondSourceX), _mm_sub_ps(pointY, secondSourceY), normalX, normalY);
+			__m128 firstNextDot = dot4(_mm_sub_ps(nextPointX, firstSourceX), _mm_sub_ps(nextPointY, firstSourceY), normalX, normalY);
+			__m128 secondNextDot = dot4(_mm_sub_ps(nextPointX, secondSourceX), _mm_sub_ps(nextPointY, secondSourceY), normalX, normalY);
 
-			firstNextEdgeRay = nextPoint - (sourceCenter - perpendicularOffset);
-			secondNextEdgeRay = nextPoint - (sourceCenter + perpendicularOffset);
+			setFacing4(facingFrontBothEdges, facingFrontOneEdge, i, firstDot, secondDot, firstNextDot, secondNextDot);
 		}
+#endif
 
-		sf::Vector2f pointToNextPoint = nextPoint - point;
+		for (; i < numPoints; i++) {
+			sf::Vector2f point = caster.getPoint(i);
+			sf::Vector2f nextPoint = caster.getPoint(i + 1);
 
-		sf::Vector2f normal = vectorNormalize(sf::Vector2f(-pointToNextPoint.y, pointToNextPoint.x));
+			sf::Vector2f source = point - sourceOffset;
 
-		// Front facing, mark it
-		facingFrontBothEdges.push_back((vectorDot(firstEdgeRay, normal) > 0.0f && vectorDot(secondEdgeRay, normal) > 0.0f) || vectorDot(firstNextEdgeRay, normal) > 0.0f && vectorDot(secondNextEdgeRay, normal) > 0.0f);
-		facingFrontOneEdge.push_back((vectorDot(firstEdgeRay, normal) > 0.0f || vectorDot(secondEdgeRay, normal) > 0.0f) || vectorDot(firstNextEdgeRay, normal) > 0.0f || vectorDot(secondNextEdgeRay, normal) > 0.0f);
+			setFacing(facingFrontBothEdges, facingFrontOneEdge, i,
+				point - (source - perpendicularOffset), point - (source + perpendicularOffset),
+				nextPoint - (source - perpendicularOffset), nextPoint - (source + perpendicularOffset),
+				sf::Vector2f(caster._normalX[i], caster._normalY[i]));
+		}
 	}
+}
+
+void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vector<int> &innerBoundaryIndices, std::vector<sf::Vector2f> &innerBoundaryVectors, std::vector<int> &outerBoundaryIndices, std::vector<sf::Vector2f> &outerBoundaryVectors, const ShadowCaster &caster, const sf::Vector2f &sourceCenter, float sourceRadius) {
+	const int numPoints = caster.getPointCount();
+
+	std::vector<bool> bothEdgesBoundaryWindings;
+	bothEdgesBoundaryWindings.reserve(2);
+
+	std::vector<bool> oneEdgeBoundaryWindings;
+	oneEdgeBoundaryWindings.reserve(2);
+
+	// Calculate front and back facing sides
+	std::vector<char> facingFrontBothEdges(numPoints);
+	std::vector<char> facingFrontOneEdge(numPoints);
+
+	getFacingPoint(facingFrontBothEdges, facingFrontOneEdge, caster, sourceCenter, sourceRadius);
 
 	// Go through front/back facing list. Where the facing direction switches, there is a boundary
 	for (int i = 1; i < numPoints; i++)
@@ -101,7 +216,7 @@ void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vecto
 		int penumbraIndex = outerBoundaryIndices[bi];
 		bool winding = oneEdgeBoundaryWindings[bi];
 
-		sf::Vector2f point = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex));
+		sf::Vector2f point = caster.getPoint(penumbraIndex);
 
 		sf::Vector2f sourceToPoint = point - sourceCenter;
 
@@ -121,7 +236,7 @@ void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vecto
 		int penumbraIndex = innerBoundaryIndices[bi];
 		bool winding = bothEdgesBoundaryWindings[bi];
 
-		sf::Vector2f point = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex));
+		sf::Vector2f point = caster.getPoint(penumbraIndex);
 
 		sf::Vector2f sourceToPoint = point - sourceCenter;
 
@@ -155,11 +270,11 @@ void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vecto
 
 			if (penumbraIndex < numPoints - 1) {
 				nextPointIndex = penumbraIndex + 1;
-				nextPoint = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex + 1));
+				nextPoint = caster.getPoint(penumbraIndex + 1);
 			}
 			else {
 				nextPointIndex = 0;
-				nextPoint = shape.getTransform().transformPoint(shape.getPoint(0));
+				nextPoint = caster.getPoint(0);
 			}
 
 			sf::Vector2f pointToNextPoint = nextPoint - point;
@@ -169,11 +284,11 @@ void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vecto
 
 			if (penumbraIndex > 0) {
 				prevPointIndex = penumbraIndex - 1;
-				prevPoint = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex - 1));
+				prevPoint = caster.getPoint(penumbraIndex - 1);
 			}
 			else {
 				prevPointIndex = numPoints - 1;
-				prevPoint = shape.getTransform().transformPoint(shape.getPoint(numPoints - 1));
+				prevPoint = caster.getPoint(numPoints - 1);
 			}
 
 			sf::Vector2f pointToPrevPoint = prevPoint - point;
@@ -214,7 +329,7 @@ void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vecto
 
 					prevPenumbraLightEdgeVector = penumbra._darkEdge;
 
-					point = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex));
+					point = caster.getPoint(penumbraIndex);
 
 					sourceToPoint = point - sourceCenter;
 
@@ -283,7 +398,7 @@ void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vecto
 
 					prevPenumbraLightEdgeVector = penumbra._darkEdge;
 
-					point = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex));
+					point = caster.getPoint(penumbraIndex);
 
 					sourceToPoint = point - sourceCenter;
 
@@ -328,8 +443,8 @@ void LightSystem::getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vecto
 	}
 }
 
-void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::vector<int> &innerBoundaryIndices, std::vector<sf::Vector2f> &innerBoundaryVectors, std::vector<int> &outerBoundaryIndices, std::vector<sf::Vector2f> &outerBoundaryVectors, const sf::ConvexShape &shape, const sf::Vector2f &sourceDirection, float sourceRadius, float sourceDistance) {
-	const int numPoints = shape.getPointCount();
+void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::vector<int> &innerBoundaryIndices, std::vector<sf::Vector2f> &innerBoundaryVectors, std::vector<int> &outerBoundaryIndices, std::vector<sf::Vector2f> &outerBoundaryVectors, const ShadowCaster &caster, const sf::Vector2f &sourceDirection, float sourceRadius, float sourceDistance) {
+	const int numPoints = caster.getPointCount();
 
 	innerBoundaryIndices.reserve(2);
 	innerBoundaryVectors.reserve(2);
@@ -339,46 +454,10 @@ void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::v
 	bothEdgesBoundaryWindings.reserve(2);
 
 	// Calculate front and back facing sides
-	std::vector<bool> facingFrontBothEdges;
-	facingFrontBothEdges.reserve(numPoints);
-
-	std::vector<bool> facingFrontOneEdge;
-	facingFrontOneEdge.reserve(numPoints);
-
-	for (int i = 0; i < numPoints; i++) {
-		sf::Vector2f point = shape.getTransform().transformPoint(shape.getPoint(i));
-
-		sf::Vector2f nextPoint;
+	std::vector<char> facingFrontBothEdges(numPoints);
+	std::vector<char> facingFrontOneEdge(numPoints);
 
-		if (i < numPoints - 1)
-			nextPoint = shape.getTransform().transformPoint(shape.getPoint(i + 1));
-		else
-			nextPoint = shape.getTransform().transformPoint(shape.getPoint(0));
-
-		sf::Vector2f firstEdgeRay;
-		sf::Vector2f secondEdgeRay;
-		sf::Vector2f firstNextEdgeRay;
-		sf::Vector2f secondNextEdgeRay;
-
-		sf::Vector2f perpendicularOffset(-sourceDirection.y, sourceDirection.x);
-
-		perpendicularOffset = vectorNormalize(perpendicularOffset);
-		perpendicularOffset *= sourceRadius;
-
-		firstEdgeRay = point - (point - sourceDirection * sourceDistance - perpendicularOffset);
-		secondEdgeRay = point - (point - sourceDirection * sourceDistance + perpendicularOffset);
-
-		firstNextEdgeRay = nextPoint - (point - sourceDirection * sourceDistance - perpendicularOffset);
-		secondNextEdgeRay = nextPoint - (point - sourceDirection * sourceDistance + perpendicularOffset);
-
-		sf::Vector2f pointToNextPoint = nextPoint - point;
-
-		sf::Vector2f normal = vectorNormalize(sf::Vector2f(-pointToNextPoint.y, pointToNextPoint.x));
-
-		// Front facing, mark it
-		facingFrontBothEdges.push_back((vectorDot(firstEdgeRay, normal) > 0.0f && vectorDot(secondEdgeRay, normal) > 0.0f) || vectorDot(firstNextEdgeRay, normal) > 0.0f && vectorDot(secondNextEdgeRay, normal) > 0.0f);
-		facingFrontOneEdge.push_back((vectorDot(firstEdgeRay, normal) > 0.0f || vectorDot(secondEdgeRay, normal) > 0.0f) || vectorDot(firstNextEdgeRay, normal) > 0.0f || vectorDot(secondNextEdgeRay, normal) > 0.0f);
-	}
+	getFacingDirection(facingFrontBothEdges, facingFrontOneEdge, caster, sourceDirection, sourceRadius, sourceDistance);
 
 	// Go through front/back facing list. Where the facing direction switches, there is a boundary
 	for (int i = 1; i < numPoints; i++)
@@ -406,7 +485,7 @@ void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::v
 		int penumbraIndex = innerBoundaryIndices[bi];
 		bool winding = bothEdgesBoundaryWindings[bi];
 
-		sf::Vector2f point = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex));
+		sf::Vector2f point = caster.getPoint(penumbraIndex);
 
 		sf::Vector2f perpendicularOffset(-sourceDirection.y, sourceDirection.x);
 
@@ -437,11 +516,11 @@ void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::v
 
 			if (penumbraIndex < numPoints - 1) {
 				nextPointIndex = penumbraIndex + 1;
-				nextPoint = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex + 1));
+				nextPoint = caster.getPoint(penumbraIndex + 1);
 			}
 			else {
 				nextPointIndex = 0;
-				nextPoint = shape.getTransform().transformPoint(shape.getPoint(0));
+				nextPoint = caster.getPoint(0);
 			}
 
 			sf::Vector2f pointToNextPoint = nextPoint - point;
@@ -451,11 +530,11 @@ void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::v
 
 			if (penumbraIndex > 0) {
 				prevPointIndex = penumbraIndex - 1;
-				prevPoint = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex - 1));
+				prevPoint = caster.getPoint(penumbraIndex - 1);
 			}
 			else {
 				prevPointIndex = numPoints - 1;
-				prevPoint = shape.getTransform().transformPoint(shape.getPoint(numPoints - 1));
+				prevPoint = caster.getPoint(numPoints - 1);
 			}
 
 			sf::Vector2f pointToPrevPoint = prevPoint - point;
@@ -496,7 +575,7 @@ void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::v
 
 					prevPenumbraLightEdgeVector = penumbra._darkEdge;
 
-					point = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex));
+					point = caster.getPoint(penumbraIndex);
 
 					perpendicularOffset = sf::Vector2f(-sourceDirection.y, sourceDirection.x);
 
@@ -553,7 +632,7 @@ void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::v
 
 					prevPenumbraLightEdgeVector = penumbra._darkEdge;
 
-					point = shape.getTransform().transformPoint(shape.getPoint(penumbraIndex));
+					point = caster.getPoint(penumbraIndex);
 
 					perpendicularOffset = sf::Vector2f(-sourceDirection.y, sourceDirection.x);
 
@@ -586,15 +665,148 @@ void LightSystem::getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::v
 	}
 }
 void LightSystem::clear(sf::RenderTarget &rt, const sf::Color &color) {
-	sf::RectangleShape shape;
-	shape.setSize(sf::Vector2f(rt.getSize().x, rt.getSize().y));
-	shape.setFillColor(color);
+	rt.clear(color);
+}
+
+void LightSystem::clear(sf::RenderTarget &rt, const sf::Color &color, const sf::IntRect &region) {
+	sf::Vector2f lowerBound(region.left, region.top);
+	sf::Vector2f upperBound(region.left + region.width, region.top + region.height);
+
+	sf::Vertex vertices[4] = {
+		sf::Vertex(lowerBound, color),
+		sf::Vertex(sf::Vector2f(upperBound.x, lowerBound.y), color),
+		sf::Vertex(upperBound, color),
+		sf::Vertex(sf::Vector2f(lowerBound.x, upperBound.y), color)
+	};
+
+	// Replace rather than blend, as a real clear would
+	sf::RenderStates states;
+	states.blendMode = sf::BlendNone;
+
+	sf::View v = rt.getView();
+	rt.setView(rt.getDefaultView());
+	rt.draw(vertices, 4, sf::Quads, states);
+	rt.setView(v);
+}
+
+sf::IntRect LightSystem::getPixelRegion(const sf::RenderTarget &rt, const sf::View &view, const sf::FloatRect &rect) {
+	sf::Vector2f lowerBound = rectLowerBound(rect);
+	sf::Vector2f upperBound = rectUpperBound(rect);
+
+	// The view may be rotated, so map all corners
+	sf::Vector2i corners[4] = {
+		rt.mapCoordsToPixel(lowerBound, view),
+		rt.mapCoordsToPixel(sf::Vector2f(upperBound.x, lowerBound.y), view),
+		rt.mapCoordsToPixel(upperBound, view),
+		rt.mapCoordsToPixel(sf::Vector2f(lowerBound.x, upperBound.y), view)
+	};
+
+	sf::Vector2i pixelLowerBound = corners[0];
+	sf::Vector2i pixelUpperBound = corners[0];
+
+	for (int i = 1; i < 4; i++) {
+		pixelLowerBound.x = std::min(pixelLowerBound.x, corners[i].x);
+		pixelLowerBound.y = std::min(pixelLowerBound.y, corners[i].y);
+		pixelUpperBound.x = std::max(pixelUpperBound.x, corners[i].x);
+		pixelUpperBound.y = std::max(pixelUpperBound.y, corners[i].y);
+	}
+
+	// A pixel of margin for rounding
+	int left = std::max(pixelLowerBound.x - 1, 0);
+	int top = std::max(pixelLowerBound.y - 1, 0);
+	int right = std::min(pixelUpperBound.x + 2, static_cast<int>(rt.getSize().x));
+	int bottom = std::min(pixelUpperBound.y + 2, static_cast<int>(rt.getSize().y));
+
+	return sf::IntRect(left, top, std::max(right - left, 0), std::max(bottom - top, 0));
+}
+
+sf::View LightSystem::getRegionView(const sf::RenderTarget &rt, const sf::View &view, const sf::IntRect &region) {
+	sf::IntRect viewport = rt.getViewport(view);
+
+	sf::View regionView = view;
+
+	regionView.setViewport(sf::FloatRect(static_cast<float>(region.left) / rt.getSize().x, static_cast<float>(region.top) / rt.getSize().y,
+		static_cast<float>(region.width) / rt.getSize().x, static_cast<float>(region.height) / rt.getSize().y));
+
+	regionView.setSize(view.getSize().x * region.width / viewport.width, view.getSize().y * region.height / viewport.height);
+
+	regionView.setCenter((rt.mapPixelToCoords(sf::Vector2i(region.left, region.top), view) +
+		rt.mapPixelToCoords(sf::Vector2i(region.left + region.width, region.top + region.height), view)) * 0.5f);
+
+	return regionView;
+}
+
+void LightSystem::drawRegion(sf::RenderTarget &rt, const sf::Texture &texture, const sf::IntRect &region, const sf::RenderStates &states) {
+	sf::Sprite sprite;
+
+	sprite.setTexture(texture);
+	sprite.setTextureRect(region);
+	sprite.setPosition(region.left, region.top);
+
 	sf::View v = rt.getView();
 	rt.setView(rt.getDefaultView());
-	rt.draw(shape);
+	rt.draw(sprite, states);
 	rt.setView(v);
 }
 
+void LightSystem::appendPenumbra(std::vector<sf::Vertex> &vertices, const Penumbra &penumbra, float shadowExtension) {
+	sf::Color brightness(static_cast<sf::Uint8>(penumbra._lightBrightness * 255.0f + 0.5f), static_cast<sf::Uint8>(penumbra._darkBrightness * 255.0f + 0.5f), 0);
+
+	vertices.push_back(sf::Vertex(penumbra._source, brightness, sf::Vector2f(0.0f, 1.0f)));
+	vertices.push_back(sf::Vertex(penumbra._source + vectorNormalize(penumbra._lightEdge) * shadowExtension, brightness, sf::Vector2f(1.0f, 0.0f)));
+	vertices.push_back(sf::Vertex(penumbra._source + vectorNormalize(penumbra._darkEdge) * shadowExtension, brightness, sf::Vector2f(0.0f, 0.0f)));
+}
+
+void LightSystem::bakeLight(LightPointEmission* pPointEmissionLight, const sf::Vector2f &pixelDensity, sf::Shader &unshadowShader, sf::Shader &lightOverShapeShader) {
+	sf::FloatRect region = pPointEmissionLight->getQuadtreeAABB();
+
+	// As many texels per world unit as the view has pixels, so the lightmap matches what rendering
+	// the light live drew. The light is rendered into the corner of the temporary textures, so a
+	// light larger than them is baked at a lower density
+	sf::Vector2u tempSize = _lightTempTexture.getSize();
+	unsigned int maxSize = sf::Texture::getMaximumSize();
+
+	sf::Vector2u size(std::min(std::max(static_cast<unsigned int>(std::ceil(region.width * pixelDensity.x)), 1u), std::min(tempSize.x, maxSize)),
+		std::min(std::max(static_cast<unsigned int>(std::ceil(region.height * pixelDensity.y)), 1u), std::min(tempSize.y, maxSize)));
+
+	// Whole texels, so the lightmap may reach a little past the AABB
+	sf::FloatRect bakedRegion(region.left, region.top,
+		std::max(region.width, size.x / pixelDensity.x), std::max(region.height, size.y / pixelDensity.y));
+
+	sf::View bakeView(bakedRegion);
+
+	bakeView.setViewport(sf::FloatRect(0.0f, 0.0f, static_cast<float>(size.x) / tempSize.x, static_cast<float>(size.y) / tempSize.y));
+
+	pPointEmissionLight->render(bakeView, _lightTempTexture, _emissionTempTexture, _antumbraTempTexture, _queriedLightShapes, unshadowShader, lightOverShapeShader);
+
+	if (pPointEmissionLight->_pBakedTexture == nullptr || pPointEmissionLight->_pBakedTexture->getSize() != size) {
+		pPointEmissionLight->_pBakedTexture.reset(new sf::RenderTexture());
+
+		pPointEmissionLight->_pBakedTexture->create(size.x, size.y);
+	}
+
+	sf::RenderTexture &bakedTexture = *pPointEmissionLight->_pBakedTexture;
+
+	// Copied texel for texel
+	sf::Sprite sprite;
+
+	sprite.setTexture(_lightTempTexture.getTexture());
+	sprite.setTextureRect(sf::IntRect(0, 0, size.x, size.y));
+
+	sf::RenderStates bakeRenderStates;
+	bakeRenderStates.blendMode = sf::BlendNone;
+
+	bakedTexture.setView(bakedTexture.getDefaultView());
+
+	bakedTexture.draw(sprite, bakeRenderStates);
+
+	bakedTexture.display();
+
+	pPointEmissionLight->_bakedRegion = bakedRegion;
+	pPointEmissionLight->_bakedPixelDensity = pixelDensity;
+	pPointEmissionLight->_baked = true;
+}
+
 void LightSystem::create(const sf::FloatRect &rootRegion, const sf::Vector2u &imageSize, const sf::Texture &penumbraTexture, sf::Shader &unshadowShader, sf::Shader &lightOverShapeShader) {
 	_shapeQuadtree.create(rootRegion);
 	_lightPointEmissionQuadtree.create(rootRegion);
@@ -613,6 +825,10 @@ void LightSystem::create(const sf::FloatRect &rootRegion, const sf::Vector2u &im
 }
 
 void LightSystem::render(const sf::View &view, sf::Shader &unshadowShader, sf::Shader &lightOverShapeShader) {
+	// Apply the moves of lights and shapes marked with quadtreeMarkDirty since the last frame
+	_shapeQuadtree.updateDirtyOccupants();
+	_lightPointEmissionQuadtree.updateDirtyOccupants();
+
 	clear(_compositionTexture, _ambientColor);
 	_compositionTexture.setView(_compositionTexture.getDefaultView());
 
@@ -626,28 +842,62 @@ void LightSystem::render(const sf::View &view, sf::Shader &unshadowShader, sf::S
 	viewBounds = rectExpand(viewBounds, _lightTempTexture.mapPixelToCoords(sf::Vector2i(_lightTempTexture.getSize().x, _lightTempTexture.getSize().y)));
 	viewBounds = rectExpand(viewBounds, _lightTempTexture.mapPixelToCoords(sf::Vector2i(0, _lightTempTexture.getSize().y)));
 
-	std::vector<QuadtreeOccupant*> viewPointEmissionLights;
+	_viewPointEmissionLights.clear();
+
+	_lightPointEmissionQuadtree.queryRegion(_viewPointEmissionLights, viewBounds);
 
-	_lightPointEmissionQuadtree.queryRegion(viewPointEmissionLights, viewBounds);
+	// Pixels per world unit, lightmaps are baked again when the view zooms
+	sf::IntRect viewport = _lightTempTexture.getViewport(view);
 
-	for (int l = 0; l < viewPointEmissionLights.size(); l++) {
-		LightPointEmission* pPointEmissionLight = static_cast<LightPointEmission*>(viewPointEmissionLights[l]);
+	sf::Vector2f pixelDensity(viewport.width / std::abs(view.getSize().x), viewport.height / std::abs(view.getSize().y));
+
+	for (int l = 0; l < _viewPointEmissionLights.size(); l++) {
+		LightPointEmission* pPointEmissionLight = static_cast<LightPointEmission*>(_viewPointEmissionLights[l]);
 
 		// Query shapes this light is affected by
-		std::vector<QuadtreeOccupant*> lightShapes;
+		_queriedLightShapes.clear();
 
-		_shapeQuadtree.queryRegion(lightShapes, pPointEmissionLight->getAABB());
+		_shapeQuadtree.queryRegion(_queriedLightShapes, pPointEmissionLight->getQuadtreeAABB());
 
-		pPointEmissionLight->render(view, _lightTempTexture, _emissionTempTexture, _antumbraTempTexture, lightShapes, unshadowShader, lightOverShapeShader);
+		// Static lights are baked once they and their shapes stayed the same for a frame,
+		// after that the lightmap is drawn in place of rendering the light
+		if (pPointEmissionLight->_static && pPointEmissionLight->updateBakeState(_queriedLightShapes)) {
+			if (!pPointEmissionLight->_baked || pPointEmissionLight->_bakedPixelDensity != pixelDensity)
+				bakeLight(pPointEmissionLight, pixelDensity, unshadowShader, lightOverShapeShader);
 
-		sf::Sprite sprite;
+			const sf::FloatRect &bakedRegion = pPointEmissionLight->_bakedRegion;
+			const sf::Texture &bakedTexture = pPointEmissionLight->_pBakedTexture->getTexture();
 
-		sprite.setTexture(_lightTempTexture.getTexture());
+			sf::Sprite sprite;
+
+			sprite.setTexture(bakedTexture);
+			sprite.setPosition(bakedRegion.left, bakedRegion.top);
+			sprite.setScale(bakedRegion.width / bakedTexture.getSize().x, bakedRegion.height / bakedTexture.getSize().y);
+
+			sf::RenderStates compoRenderStates;
+			compoRenderStates.blendMode = sf::BlendAdd;
+
+			_compositionTexture.setView(view);
+
+			_compositionTexture.draw(sprite, compoRenderStates);
+
+			_compositionTexture.setView(_compositionTexture.getDefaultView());
+
+			continue;
+		}
+
+		// Only the pixels the light covers are rendered and composited
+		sf::IntRect region = getPixelRegion(_lightTempTexture, view, pPointEmissionLight->getQuadtreeAABB());
+
+		if (region.width == 0 || region.height == 0)
+			continue;
+
+		pPointEmissionLight->render(getRegionView(_lightTempTexture, view, region), _lightTempTexture, _emissionTempTexture, _antumbraTempTexture, _queriedLightShapes, unshadowShader, lightOverShapeShader);
 
 		sf::RenderStates compoRenderStates;
 		compoRenderStates.blendMode = sf::BlendAdd;
 
-		_compositionTexture.draw(sprite, compoRenderStates);
+		drawRegion(_compositionTexture, _lightTempTexture.getTexture(), region, compoRenderStates);
 	}
 	
 	for (std::unordered_set<std::shared_ptr<LightDirectionEmission>>::iterator it = _directionEmissionLights.begin(); it != _directionEmissionLights.end(); it++) {
@@ -662,19 +912,19 @@ void LightSystem::render(const sf::View &view, sf::Shader &unshadowShader, sf::S
 
 		float shadowExtension = vectorMagnitude(rectLowerBound(centeredViewBounds)) * _directionEmissionRadiusMultiplier * 2.0f;
 
-		sf::ConvexShape directionShape = shapeFromRect(extendedViewBounds);
+		shapeFromRect(extendedViewBounds, _directionShape);
 
-		directionShape.setPosition(view.getCenter());
+		_directionShape.setPosition(view.getCenter());
 
 		sf::Vector2f normalizedCastDirection = vectorNormalize(pDirectionEmissionLight->_castDirection);
 
-		directionShape.setRotation(_radToDeg * std::atan2(normalizedCastDirection.y, normalizedCastDirection.x));
+		_directionShape.setRotation(_radToDeg * std::atan2(normalizedCastDirection.y, normalizedCastDirection.x));
 
-		std::vector<QuadtreeOccupant*> viewLightShapes;
+		_queriedLightShapes.clear();
 
-		_shapeQuadtree.queryShape(viewLightShapes, directionShape);
+		_shapeQuadtree.queryShape(_queriedLightShapes, _directionShape);
 
-		pDirectionEmissionLight->render(view, _lightTempTexture, _antumbraTempTexture, viewLightShapes, unshadowShader, shadowExtension);
+		pDirectionEmissionLight->render(view, _lightTempTexture, _antumbraTempTexture, _queriedLightShapes, unshadowShader, shadowExtension);
 
 		sf::Sprite sprite;
 
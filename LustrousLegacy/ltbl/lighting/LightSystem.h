@@ -23,10 +23,29 @@ namespace ltbl {
 	private:
 		sf::RenderTexture _lightTempTexture, _emissionTempTexture, _antumbraTempTexture, _compositionTexture;
 
-		static void getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vector<int> &innerBoundaryIndices, std::vector<sf::Vector2f> &innerBoundaryVectors, std::vector<int> &outerBoundaryIndices, std::vector<sf::Vector2f> &outerBoundaryVectors, const sf::ConvexShape &shape, const sf::Vector2f &sourceCenter, float sourceRadius);
-		static void getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::vector<int> &innerBoundaryIndices, std::vector<sf::Vector2f> &innerBoundaryVectors, std::vector<int> &outerBoundaryIndices, std::vector<sf::Vector2f> &outerBoundaryVectors, const sf::ConvexShape &shape, const sf::Vector2f &sourceDirection, float sourceRadius, float sourceDistance);
+		static void getPenumbrasPoint(std::vector<Penumbra> &penumbras, std::vector<int> &innerBoundaryIndices, std::vector<sf::Vector2f> &innerBoundaryVectors, std::vector<int> &outerBoundaryIndices, std::vector<sf::Vector2f> &outerBoundaryVectors, const ShadowCaster &caster, const sf::Vector2f &sourceCenter, float sourceRadius);
+		static void getPenumbrasDirection(std::vector<Penumbra> &penumbras, std::vector<int> &innerBoundaryIndices, std::vector<sf::Vector2f> &innerBoundaryVectors, std::vector<int> &outerBoundaryIndices, std::vector<sf::Vector2f> &outerBoundaryVectors, const ShadowCaster &caster, const sf::Vector2f &sourceDirection, float sourceRadius, float sourceDistance);
 
 		static void clear(sf::RenderTarget &rt, const sf::Color &color);
+
+		// Clears only the given pixels of the target
+		static void clear(sf::RenderTarget &rt, const sf::Color &color, const sf::IntRect &region);
+
+		// Pixels of the target covered by a world space rectangle seen through view, clipped to the target
+		static sf::IntRect getPixelRegion(const sf::RenderTarget &rt, const sf::View &view, const sf::FloatRect &rect);
+
+		// View that maps the world like view does, but only draws to the given pixels of the target
+		static sf::View getRegionView(const sf::RenderTarget &rt, const sf::View &view, const sf::IntRect &region);
+
+		// Draws the given pixels of a texture of the same size as the target in place
+		static void drawRegion(sf::RenderTarget &rt, const sf::Texture &texture, const sf::IntRect &region, const sf::RenderStates &states);
+
+		// Adds the triangle of a penumbra for unshadowShader, with its brightnesses in the vertex color
+		static void appendPenumbra(std::vector<sf::Vertex> &vertices, const Penumbra &penumbra, float shadowExtension);
+
+		// Renders a static light into its lightmap at pixelDensity texels per world unit, with
+		// _queriedLightShapes as its shapes
+		void bakeLight(LightPointEmission* pPointEmissionLight, const sf::Vector2f &pixelDensity, sf::Shader &unshadowShader, sf::Shader &lightOverShapeShader);
 		
 		DynamicQuadtree _shapeQuadtree;
 		DynamicQuadtree _lightPointEmissionQuadtree;
@@ -35,6 +54,13 @@ namespace ltbl {
 		std::unordered_set<std::shared_ptr<LightDirectionEmission>> _directionEmissionLights;
 		std::unordered_set<std::shared_ptr<LightShape>> _lightShapes;
 
+		// Query results, reused across frames so rendering does not allocate per query
+		std::vector<QuadtreeOccupant*> _viewPointEmissionLights;
+		std::vector<QuadtreeOccupant*> _queriedLightShapes;
+
+		// Area lit by the direction emission light being rendered, reused between lights
+		sf::ConvexShape _directionShape;
+
 	public:
 		float _directionEmissionRange;
 		float _directionEmissionRadiusMultiplier;
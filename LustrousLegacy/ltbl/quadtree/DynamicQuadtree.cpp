@@ -4,18 +4,13 @@
 
 using namespace ltbl;
 
-void DynamicQuadtree::operator=(const DynamicQuadtree &other) {
-	Quadtree::operator=(other);
-
-	_minOutsideRoot = other._minOutsideRoot;
-	_maxOutsideRoot = other._maxOutsideRoot;
-}
-
 void DynamicQuadtree::add(QuadtreeOccupant* oc) {
 	assert(created());
 
+	oc->_quadtreeAABB = oc->getAABB();
+
 	// If the occupant fits in the root node
-	if (rectContains(_pRootNode->getRegion(), oc->getAABB()))
+	if (rectContains(_pRootNode->getRegion(), oc->_quadtreeAABB))
 		_pRootNode->add(oc);
 	else
 		_outsideRoot.insert(oc);
@@ -27,8 +22,8 @@ void DynamicQuadtree::expand() {
 	// Find direction with most occupants
 	sf::Vector2f averageDir(0.0f, 0.0f);
 
-	for (std::unordered_set<QuadtreeOccupant*>::iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++)
-		averageDir += vectorNormalize(rectCenter((*it)->getAABB()) - rectCenter(_pRootNode->getRegion()));
+	for (QuadtreeOccupantList::const_iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++)
+		averageDir += vectorNormalize(rectCenter((*it)->_quadtreeAABB) - rectCenter(_pRootNode->getRegion()));
 
 	sf::Vector2f centerOffsetDist(rectHalfDims(_pRootNode->getRegion()) / _oversizeMultiplier);
 
@@ -42,7 +37,9 @@ void DynamicQuadtree::expand() {
 
 	newRootAABB = rectRecenter(newRootAABB, centerOffset + rectCenter(_pRootNode->getRegion()));
 
-	QuadtreeNode* pNewRoot = new QuadtreeNode(newRootAABB,  _pRootNode->_level + 1, nullptr, this);
+	int rootLevel = _pRootNode->_level;
+
+	QuadtreeNode* pNewRoot = _nodePool.create(newRootAABB, rootLevel + 1, nullptr, this);
 
 	// ----------------------- Manual Children Creation for New Root -------------------------
 
@@ -53,8 +50,12 @@ void DynamicQuadtree::expand() {
 	// Create the children nodes
 	for(int x = 0; x < 2; x++)
 		for(int y = 0; y < 2; y++) {
-			if(x == rX && y == rY)
+			if(x == rX && y == rY) {
+				// The old root becomes a child of the new root
+				_pRootNode->_pParent = pNewRoot;
+
 				pNewRoot->_children[x + y * 2].reset(_pRootNode.release());
+			}
 			else {
 				sf::Vector2f offset(x * halfRegionDims.x, y * halfRegionDims.y);
 
@@ -68,26 +69,26 @@ void DynamicQuadtree::expand() {
 
 				childAABB = rectRecenter(childAABB, center);
 	
-				pNewRoot->_children[x + y * 2].reset(new QuadtreeNode(childAABB, _pRootNode->_level, pNewRoot, this));
+				pNewRoot->_children[x + y * 2].reset(_nodePool.create(childAABB, rootLevel, pNewRoot, this));
 			}
 		}
 
 	pNewRoot->_hasChildren = true;
-	pNewRoot->_numOccupantsBelow = _pRootNode->_numOccupantsBelow;
-	_pRootNode->_pParent = pNewRoot;
+	pNewRoot->_numOccupantsBelow = pNewRoot->_children[rX + rY * 2]->_numOccupantsBelow;
 
 	// Transfer ownership
-	_pRootNode.release();
 	_pRootNode.reset(pNewRoot);
 
 	// ----------------------- Try to Add Previously Outside Root -------------------------
 
 	// Make copy so don't try to re-add ones just added
-	std::unordered_set<QuadtreeOccupant*> outsideRootCopy(_outsideRoot);
+	std::vector<QuadtreeOccupant*> outsideRootCopy(_outsideRoot.begin(), _outsideRoot.end());
 	_outsideRoot.clear();
 
-	for (std::unordered_set<QuadtreeOccupant*>::iterator it = outsideRootCopy.begin(); it != outsideRootCopy.end(); it++)
+	for (std::vector<QuadtreeOccupant*>::iterator it = outsideRootCopy.begin(); it != outsideRootCopy.end(); it++)
 		add(*it);
+
+	_expandCount++;
 }
 
 void DynamicQuadtree::contract() {
@@ -118,6 +119,8 @@ void DynamicQuadtree::contract() {
 	_pRootNode.reset(pNewRoot);
 
 	_pRootNode->_pParent = nullptr;
+
+	_contractCount++;
 }
 
 void DynamicQuadtree::trim() {
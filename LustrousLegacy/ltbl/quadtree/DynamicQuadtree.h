@@ -19,23 +19,19 @@ namespace ltbl {
 		DynamicQuadtree(const sf::FloatRect &rootRegion)
 			: _minOutsideRoot(1), _maxOutsideRoot(8)
 		{
-			_pRootNode = std::make_unique<QuadtreeNode>(rootRegion, 0, nullptr, this);
+			_pRootNode.reset(_nodePool.create(rootRegion, 0, nullptr, this));
 		}
 
-		DynamicQuadtree(const DynamicQuadtree &other) {
-			*this = other;
-		}
-
-		void operator=(const DynamicQuadtree &other);
-
 		void create(const sf::FloatRect &rootRegion) {
-			_pRootNode = std::make_unique<QuadtreeNode>(rootRegion, 0, nullptr, this);
+			_pRootNode.reset(_nodePool.create(rootRegion, 0, nullptr, this));
 		}
 
 		// Inherited from Quadtree
 		void add(QuadtreeOccupant* oc);
 
 		void clear() {
+			clearDirty();
+
 			_pRootNode.reset();
 		}
 
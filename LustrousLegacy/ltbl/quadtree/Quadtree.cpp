@@ -7,86 +7,195 @@
 using namespace ltbl;
 
 Quadtree::Quadtree()
-: _minNumNodeOccupants(3),
+: _queryCount(0), _nodesVisitedCount(0), _occupantsTestedCount(0), _occupantsReturnedCount(0),
+_partitionCount(0), _mergeCount(0), _expandCount(0), _contractCount(0),
+_minNumNodeOccupants(3),
 _maxNumNodeOccupants(6),
 _maxLevels(40),
-_oversizeMultiplier(1.0f)
+_oversizeMultiplier(1.0f),
+_recordQueryStats(false)
 {}
 
-void Quadtree::operator=(const Quadtree &other) {
-	_minNumNodeOccupants = other._minNumNodeOccupants;
-	_maxNumNodeOccupants = other._maxNumNodeOccupants;
-	_maxLevels = other._maxLevels;
-	_oversizeMultiplier = other._oversizeMultiplier;
+void Quadtree::setQuadtree(QuadtreeOccupant* oc) {
+	oc->_pQuadtree = this;
+}
 
-	_outsideRoot = other._outsideRoot;
+void Quadtree::markDirty(QuadtreeOccupant* oc) {
+	if (oc->_quadtreeDirty)
+		return;
 
-	if (other._pRootNode != nullptr) {
-		_pRootNode.reset(new QuadtreeNode());
+	oc->_quadtreeDirty = true;
+	oc->_quadtreeDirtySlot = _dirtyOccupants.size();
 
-		recursiveCopy(_pRootNode.get(), other._pRootNode.get(), nullptr);
-	}
+	_dirtyOccupants.push_back(oc);
 }
 
-void Quadtree::setQuadtree(QuadtreeOccupant* oc) {
-	oc->_pQuadtree = this;
+void Quadtree::unmarkDirty(QuadtreeOccupant* oc) {
+	if (!oc->_quadtreeDirty)
+		return;
+
+	// Swap-and-pop, same as QuadtreeOccupantList
+	QuadtreeOccupant* pLast = _dirtyOccupants.back();
+
+	_dirtyOccupants[oc->_quadtreeDirtySlot] = pLast;
+	pLast->_quadtreeDirtySlot = oc->_quadtreeDirtySlot;
+
+	_dirtyOccupants.pop_back();
+
+	oc->_quadtreeDirty = false;
+}
+
+void Quadtree::clearDirty() {
+	for (size_t i = 0; i < _dirtyOccupants.size(); i++)
+		_dirtyOccupants[i]->_quadtreeDirty = false;
+
+	_dirtyOccupants.clear();
 }
 
-void Quadtree::recursiveCopy(QuadtreeNode* pThisNode, QuadtreeNode* pOtherNode, QuadtreeNode* pThisParent) {
-	pThisNode->_hasChildren = pOtherNode->_hasChildren;
-	pThisNode->_level = pOtherNode->_level;
-	pThisNode->_numOccupantsBelow = pOtherNode->_numOccupantsBelow;
-	pThisNode->_occupants = pOtherNode->_occupants;
-	pThisNode->_region = pOtherNode->_region;
+void Quadtree::updateDirtyOccupants() {
+	if (_dirtyOccupants.empty())
+		return;
+
+	_dirtyMoves.clear();
+	_vacatedNodes.clear();
+	_mergeNodes.clear();
+
+	// Detach every occupant that has to move, without partitioning or merging anything yet
+	for (size_t i = 0; i < _dirtyOccupants.size(); i++) {
+		QuadtreeOccupant* oc = _dirtyOccupants[i];
+
+		oc->_quadtreeDirty = false;
+		oc->_quadtreeAABB = oc->getAABB();
+
+		QuadtreeNode* pOldNode = oc->_pQuadtreeNode;
 
-	pThisNode->_pParent = pThisParent;
+		if (pOldNode == nullptr) {
+			// Outside the root, stays there unless it moved inside
+			if (_pRootNode == nullptr || !rectContains(_pRootNode->_region, oc->_quadtreeAABB))
+				continue;
 
-	pThisNode->_pQuadtree = this;
+			_outsideRoot.erase(oc);
 
-	if (pThisNode->_hasChildren)
-	for (int i = 0; i < 4; i++) {
-		pThisNode->_children[i].reset(new QuadtreeNode());
+			DirtyMove move;
+			move._pNode = _pRootNode.get();
+			move._pOccupant = oc;
 
-		recursiveCopy(pThisNode->_children[i].get(), pOtherNode->_children[i].get(), pThisNode);
+			_dirtyMoves.push_back(move);
+
+			continue;
+		}
+
+		// Still fits and would not sink into a child, nothing changes
+		if (rectContains(pOldNode->_region, oc->_quadtreeAABB) && pOldNode->getFittingChild(oc) == nullptr)
+			continue;
+
+		pOldNode->_occupants.erase(oc);
+
+		_vacatedNodes.push_back(pOldNode);
+
+		// Propogate upwards, looking for a node that can contain the occupant
+		QuadtreeNode* pNode = pOldNode;
+
+		while (pNode != nullptr) {
+			pNode->_numOccupantsBelow--;
+
+			if (rectContains(pNode->_region, oc->_quadtreeAABB))
+				break;
+
+			pNode = pNode->_pParent;
+		}
+
+		if (pNode == nullptr) {
+			_outsideRoot.insert(oc);
+
+			oc->_pQuadtreeNode = nullptr;
+		}
+		else {
+			DirtyMove move;
+			move._pNode = pNode;
+			move._pOccupant = oc;
+
+			_dirtyMoves.push_back(move);
+		}
 	}
+
+	_dirtyOccupants.clear();
+
+	// Re-add grouped by node. Adding may partition but never destroys nodes
+	std::sort(_dirtyMoves.begin(), _dirtyMoves.end());
+
+	for (size_t i = 0; i < _dirtyMoves.size(); i++)
+		_dirtyMoves[i]._pNode->add(_dirtyMoves[i]._pOccupant);
+
+	// Find the highest node above each vacated node that no longer holds enough occupants
+	// to keep its children. Every node is still alive at this point
+	for (size_t i = 0; i < _vacatedNodes.size(); i++) {
+		QuadtreeNode* pMergeNode = nullptr;
+
+		for (QuadtreeNode* pNode = _vacatedNodes[i]; pNode != nullptr && pNode->_numOccupantsBelow < static_cast<int>(_minNumNodeOccupants); pNode = pNode->_pParent)
+		if (pNode->_hasChildren)
+			pMergeNode = pNode;
+
+		if (pMergeNode != nullptr)
+			_mergeNodes.push_back(pMergeNode);
+	}
+
+	std::sort(_mergeNodes.begin(), _mergeNodes.end(), std::less<QuadtreeNode*>());
+	_mergeNodes.erase(std::unique(_mergeNodes.begin(), _mergeNodes.end()), _mergeNodes.end());
+
+	// Merge only the topmost ones, merging a node destroys the nodes below it. They are
+	// picked before merging anything, so no destroyed node is visited
+	_vacatedNodes.clear();
+
+	for (size_t i = 0; i < _mergeNodes.size(); i++) {
+		bool belowOther = false;
+
+		for (QuadtreeNode* pNode = _mergeNodes[i]->_pParent; pNode != nullptr && !belowOther; pNode = pNode->_pParent)
+			belowOther = std::binary_search(_mergeNodes.begin(), _mergeNodes.end(), pNode, std::less<QuadtreeNode*>());
+
+		if (!belowOther)
+			_vacatedNodes.push_back(_mergeNodes[i]);
+	}
+
+	for (size_t i = 0; i < _vacatedNodes.size(); i++)
+		_vacatedNodes[i]->merge();
 }
 
 void Quadtree::pruneDeadReferences() {
-	for (std::unordered_set<QuadtreeOccupant*>::iterator it = _outsideRoot.begin(); it != _outsideRoot.end();)
-	if ((*it) == nullptr)
-		it++;
-	else
-		it = _outsideRoot.erase(it);
-
 	if (_pRootNode != nullptr)
 		_pRootNode->pruneDeadReferences();
 }
 
-void Quadtree::queryRegion(std::vector<QuadtreeOccupant*> &result, const sf::FloatRect &region) {
+void Quadtree::queryRegion(std::vector<QuadtreeOccupant*> &result, const sf::FloatRect &region) const {
+	size_t firstResult = result.size();
+	size_t nodesVisited = 0;
+	size_t occupantsTested = _outsideRoot.size();
+
 	// Query outside root elements
-	for (std::unordered_set<QuadtreeOccupant*>::iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++) {
+	for (QuadtreeOccupantList::const_iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++) {
 		QuadtreeOccupant* oc = *it;
-		sf::FloatRect r = oc->getAABB();
-
-		if (oc != nullptr && region.intersects(oc->getAABB()))
+		if (oc != nullptr && region.intersects(oc->_quadtreeAABB))
 			// Intersects, add to list
 			result.push_back(oc);
 	}
 
-	std::list<QuadtreeNode*> open;
+	QuadtreeNodeStack open;
 
-	open.push_back(_pRootNode.get());
+	open.push(_pRootNode.get());
 
 	while (!open.empty()) {
 		// Depth-first (results in less memory usage), remove objects from open list
-		QuadtreeNode* pCurrent = open.back();
-		open.pop_back();
+		QuadtreeNode* pCurrent = open.pop();
+
+		nodesVisited++;
 
 		if (region.intersects(pCurrent->_region)) {
-			for (std::unordered_set<QuadtreeOccupant*>::iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++) {
+			occupantsTested += pCurrent->_occupants.size();
+
+			for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++) {
 				QuadtreeOccupant* oc = *it;
 
-				if (oc != nullptr && region.intersects(oc->getAABB()))
+				if (oc != nullptr && region.intersects(oc->_quadtreeAABB))
 					// Visible, add to list
 					result.push_back(oc);
 			}
@@ -95,35 +204,44 @@ void Quadtree::queryRegion(std::vector<QuadtreeOccupant*> &result, const sf::Flo
 			if (pCurrent->_hasChildren)
 			for (int i = 0; i < 4; i++)
 			if (pCurrent->_children[i]->getNumOccupantsBelow() != 0)
-				open.push_back(pCurrent->_children[i].get());
+				open.push(pCurrent->_children[i].get());
 		}
 	}
+
+	recordQuery(1, nodesVisited, occupantsTested, result.size() - firstResult);
 }
 
-void Quadtree::queryPoint(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p) {
+void Quadtree::queryPoint(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p) const {
+	size_t firstResult = result.size();
+	size_t nodesVisited = 0;
+	size_t occupantsTested = _outsideRoot.size();
+
 	// Query outside root elements
-	for (std::unordered_set<QuadtreeOccupant*>::iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++) {
+	for (QuadtreeOccupantList::const_iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++) {
 		QuadtreeOccupant* oc = *it;
 
-		if (oc != nullptr && oc->getAABB().contains(p))
+		if (oc != nullptr && oc->_quadtreeAABB.contains(p))
 			// Intersects, add to list
 			result.push_back(oc);
 	}
 
-	std::list<QuadtreeNode*> open;
+	QuadtreeNodeStack open;
 
-	open.push_back(_pRootNode.get());
+	open.push(_pRootNode.get());
 
 	while (!open.empty()) {
 		// Depth-first (results in less memory usage), remove objects from open list
-		QuadtreeNode* pCurrent = open.back();
-		open.pop_back();
+		QuadtreeNode* pCurrent = open.pop();
+
+		nodesVisited++;
 
 		if (pCurrent->_region.contains(p)) {
-			for (std::unordered_set<QuadtreeOccupant*>::iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++) {
+			occupantsTested += pCurrent->_occupants.size();
+
+			for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++) {
 				QuadtreeOccupant* oc = *it;
 
-				if (oc != nullptr && oc->getAABB().contains(p))
+				if (oc != nullptr && oc->_quadtreeAABB.contains(p))
 					// Visible, add to list
 					result.push_back(oc);
 			}
@@ -132,36 +250,43 @@ void Quadtree::queryPoint(std::vector<QuadtreeOccupant*> &result, const sf::Vect
 			if (pCurrent->_hasChildren)
 			for (int i = 0; i < 4; i++)
 			if (pCurrent->_children[i]->getNumOccupantsBelow() != 0)
-				open.push_back(pCurrent->_children[i].get());
+				open.push(pCurrent->_children[i].get());
 		}
 	}
+
+	recordQuery(1, nodesVisited, occupantsTested, result.size() - firstResult);
 }
 
-void Quadtree::queryShape(std::vector<QuadtreeOccupant*> &result, const sf::ConvexShape &shape) {
+void Quadtree::queryShape(std::vector<QuadtreeOccupant*> &result, const ShapeAxes &axes) const {
+	size_t firstResult = result.size();
+	size_t nodesVisited = 0;
+	size_t occupantsTested = _outsideRoot.size();
+
 	// Query outside root elements
-	for (std::unordered_set<QuadtreeOccupant*>::iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++) {
+	for (QuadtreeOccupantList::const_iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++) {
 		QuadtreeOccupant* oc = *it;
 
-		if (oc != nullptr && shapeIntersection(shapeFromRect(oc->getAABB()), shape))
+		if (oc != nullptr && axes.intersects(oc->_quadtreeAABB))
 			// Intersects, add to list
 			result.push_back(oc);
 	}
 
-	std::list<QuadtreeNode*> open;
+	QuadtreeNodeStack open;
 
-	open.push_back(_pRootNode.get());
+	open.push(_pRootNode.get());
 
 	while (!open.empty()) {
 		// Depth-first (results in less memory usage), remove objects from open list
-		QuadtreeNode* pCurrent = open.back();
-		open.pop_back();
+		QuadtreeNode* pCurrent = open.pop();
 
-		if (shapeIntersection(shapeFromRect(pCurrent->_region), shape)) {
-			for (std::unordered_set<QuadtreeOccupant*>::iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++) {
-				QuadtreeOccupant* oc = *it;
-				sf::ConvexShape r = shapeFromRect(oc->getAABB());
+		nodesVisited++;
+
+		if (axes.intersects(pCurrent->_region)) {
+			occupantsTested += pCurrent->_occupants.size();
 
-				if (oc != nullptr && shapeIntersection(shapeFromRect(oc->getAABB()), shape))
+			for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++) {
+				QuadtreeOccupant* oc = *it;
+				if (oc != nullptr && axes.intersects(oc->_quadtreeAABB))
 					// Visible, add to list
 					result.push_back(oc);
 			}
@@ -170,7 +295,187 @@ void Quadtree::queryShape(std::vector<QuadtreeOccupant*> &result, const sf::Conv
 			if (pCurrent->_hasChildren)
 			for (int i = 0; i < 4; i++)
 			if (pCurrent->_children[i]->getNumOccupantsBelow() != 0)
-				open.push_back(pCurrent->_children[i].get());
+				open.push(pCurrent->_children[i].get());
+		}
+	}
+
+	recordQuery(1, nodesVisited, occupantsTested, result.size() - firstResult);
+}
+
+void Quadtree::queryNearest(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p, size_t k) const {
+	if (k == 0)
+		return;
+
+	// Distances are squared, the order is the same
+	QuadtreeSearchQueue<SearchItem> open;
+
+	for (QuadtreeOccupantList::const_iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++) {
+		SearchItem item = { rectDistanceSquared((*it)->_quadtreeAABB, p), nullptr, *it };
+
+		open.push(item);
+	}
+
+	if (_pRootNode != nullptr) {
+		SearchItem item = { rectDistanceSquared(_pRootNode->_region, p), _pRootNode.get(), nullptr };
+
+		open.push(item);
+	}
+
+	size_t found = 0;
+	size_t nodesVisited = 0;
+	size_t occupantsTested = _outsideRoot.size();
+
+	while (!open.empty() && found < k) {
+		SearchItem current = open.pop();
+
+		// Everything left is at least as far away, so this is the next nearest
+		if (current._pOccupant != nullptr) {
+			result.push_back(current._pOccupant);
+
+			found++;
+
+			continue;
+		}
+
+		// A node is never farther than what it contains, open it
+		QuadtreeNode* pCurrent = current._pNode;
+
+		nodesVisited++;
+		occupantsTested += pCurrent->_occupants.size();
+
+		for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++) {
+			SearchItem item = { rectDistanceSquared((*it)->_quadtreeAABB, p), nullptr, *it };
+
+			open.push(item);
+		}
+
+		if (pCurrent->_hasChildren)
+		for (int i = 0; i < 4; i++)
+		if (pCurrent->_children[i]->getNumOccupantsBelow() != 0) {
+			SearchItem item = { rectDistanceSquared(pCurrent->_children[i]->_region, p), pCurrent->_children[i].get(), nullptr };
+
+			open.push(item);
 		}
 	}
+
+	recordQuery(1, nodesVisited, occupantsTested, found);
+}
+
+bool Quadtree::raycast(const sf::Vector2f &origin, const sf::Vector2f &direction, float maxDistance, QuadtreeOccupant* &hit, float &distance) const {
+	float length = vectorMagnitude(direction);
+
+	if (length == 0.0f)
+		return false;
+
+	sf::Vector2f unitDirection = direction / length;
+
+	// Ordered by the distance at which the ray enters each node or occupant
+	QuadtreeSearchQueue<SearchItem> open;
+
+	float entryDistance;
+
+	size_t nodesVisited = 0;
+	size_t occupantsTested = _outsideRoot.size();
+
+	for (QuadtreeOccupantList::const_iterator it = _outsideRoot.begin(); it != _outsideRoot.end(); it++)
+	if (rayRectIntersect(origin, unitDirection, maxDistance, (*it)->_quadtreeAABB, entryDistance)) {
+		SearchItem item = { entryDistance, nullptr, *it };
+
+		open.push(item);
+	}
+
+	if (_pRootNode != nullptr && rayRectIntersect(origin, unitDirection, maxDistance, _pRootNode->_region, entryDistance)) {
+		SearchItem item = { entryDistance, _pRootNode.get(), nullptr };
+
+		open.push(item);
+	}
+
+	while (!open.empty()) {
+		SearchItem current = open.pop();
+
+		// Nothing left can be entered sooner
+		if (current._pOccupant != nullptr) {
+			hit = current._pOccupant;
+			distance = current._distance;
+
+			recordQuery(1, nodesVisited, occupantsTested, 1);
+
+			return true;
+		}
+
+		QuadtreeNode* pCurrent = current._pNode;
+
+		nodesVisited++;
+		occupantsTested += pCurrent->_occupants.size();
+
+		for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
+		if (rayRectIntersect(origin, unitDirection, maxDistance, (*it)->_quadtreeAABB, entryDistance)) {
+			SearchItem item = { entryDistance, nullptr, *it };
+
+			open.push(item);
+		}
+
+		if (pCurrent->_hasChildren)
+		for (int i = 0; i < 4; i++)
+		if (pCurrent->_children[i]->getNumOccupantsBelow() != 0 && rayRectIntersect(origin, unitDirection, maxDistance, pCurrent->_children[i]->_region, entryDistance)) {
+			SearchItem item = { entryDistance, pCurrent->_children[i].get(), nullptr };
+
+			open.push(item);
+		}
+	}
+
+	recordQuery(1, nodesVisited, occupantsTested, 0);
+
+	return false;
+}
+
+QuadtreeStats Quadtree::getStats() const {
+	QuadtreeStats stats;
+
+	stats._queries = _queryCount.load(std::memory_order_relaxed);
+	stats._nodesVisited = _nodesVisitedCount.load(std::memory_order_relaxed);
+	stats._occupantsTested = _occupantsTestedCount.load(std::memory_order_relaxed);
+	stats._occupantsReturned = _occupantsReturnedCount.load(std::memory_order_relaxed);
+
+	stats._partitions = _partitionCount;
+	stats._merges = _mergeCount;
+	stats._expands = _expandCount;
+	stats._contracts = _contractCount;
+
+	stats._outsideRoot = _outsideRoot.size();
+	stats._nodePool = _nodePool.getStats();
+
+	if (_pRootNode == nullptr)
+		return stats;
+
+	// Node levels count down from the root, and expand() can raise the root level
+	int rootLevel = _pRootNode->_level;
+
+	QuadtreeNodeStack open;
+
+	open.push(_pRootNode.get());
+
+	while (!open.empty()) {
+		QuadtreeNode* pCurrent = open.pop();
+
+		stats.addNodeAtDepth(rootLevel - pCurrent->_level, pCurrent->_occupants.size());
+
+		if (pCurrent->_hasChildren)
+		for (int i = 0; i < 4; i++)
+			open.push(pCurrent->_children[i].get());
+	}
+
+	return stats;
+}
+
+void Quadtree::resetStats() {
+	_queryCount = 0;
+	_nodesVisitedCount = 0;
+	_occupantsTestedCount = 0;
+	_occupantsReturnedCount = 0;
+
+	_partitionCount = 0;
+	_mergeCount = 0;
+	_expandCount = 0;
+	_contractCount = 0;
 }
\ No newline at end of file
@@ -1,22 +1,81 @@
 #pragma once
 
 #include <ltbl/quadtree/QuadtreeNode.h>
+#include <ltbl/quadtree/QuadtreeNodePool.h>
+#include <ltbl/quadtree/QuadtreeStats.h>
 
 #include <memory>
+#include <functional>
+#include <atomic>
 
 #include <unordered_set>
-#include <list>
-
-#include <mutex>
-#include <thread>
 
 namespace ltbl {
-	// Base class for dynamic and static Quadtree types
-	class Quadtree {
+	// Base class for dynamic and static Quadtree types.
+	// Queries only read the tree and keep their traversal state on the stack, so any
+	// number of threads may query the same tree at once as long as nothing modifies it
+	// meanwhile. Adding, removing, updating, marking dirty, trimming, building and
+	// clearing are writes and need the tree to themselves. A frame would run them from
+	// one thread, then fan the queries out. Each thread needs its own result vector.
+	// A shared sf::ConvexShape is not safe to read from several threads (SFML updates
+	// its transform lazily), so share a ShapeAxes built beforehand instead.
+	// Occupants point back at the tree and node holding them, so trees are not copyable
+	class Quadtree : public sf::NonCopyable {
 	protected:
-		std::unordered_set<QuadtreeOccupant*> _outsideRoot;
-
-		std::unique_ptr<QuadtreeNode> _pRootNode;
+		QuadtreeOccupantList _outsideRoot;
+
+		// Declared before the root so it outlives every node
+		QuadtreeNodePool _nodePool;
+
+		QuadtreeNodePtr _pRootNode;
+
+		// Occupants waiting for updateDirtyOccupants
+		std::vector<QuadtreeOccupant*> _dirtyOccupants;
+
+		// Scratch buffers of updateDirtyOccupants
+		struct DirtyMove {
+			QuadtreeNode* _pNode;
+			QuadtreeOccupant* _pOccupant;
+
+			bool operator<(const DirtyMove &other) const {
+				return std::less<QuadtreeNode*>()(_pNode, other._pNode);
+			}
+		};
+
+		std::vector<DirtyMove> _dirtyMoves;
+		std::vector<QuadtreeNode*> _vacatedNodes;
+		std::vector<QuadtreeNode*> _mergeNodes;
+
+		// Entry of the open list of queryNearest and raycast, either a node or an occupant
+		struct SearchItem {
+			float _distance;
+
+			QuadtreeNode* _pNode;
+			QuadtreeOccupant* _pOccupant;
+		};
+
+		// Query counters, only kept while _recordQueryStats is set. Queries may run
+		// concurrently, each one adds its totals once at the end
+		mutable std::atomic<size_t> _queryCount;
+		mutable std::atomic<size_t> _nodesVisitedCount;
+		mutable std::atomic<size_t> _occupantsTestedCount;
+		mutable std::atomic<size_t> _occupantsReturnedCount;
+
+		// Structure counters, only changed by writes
+		size_t _partitionCount;
+		size_t _mergeCount;
+		size_t _expandCount;
+		size_t _contractCount;
+
+		void recordQuery(size_t queries, size_t nodesVisited, size_t occupantsTested, size_t occupantsReturned) const {
+			if (!_recordQueryStats)
+				return;
+
+			_queryCount.fetch_add(queries, std::memory_order_relaxed);
+			_nodesVisitedCount.fetch_add(nodesVisited, std::memory_order_relaxed);
+			_occupantsTestedCount.fetch_add(occupantsTested, std::memory_order_relaxed);
+			_occupantsReturnedCount.fetch_add(occupantsReturned, std::memory_order_relaxed);
+		}
 
 		// Called whenever something is removed, an action can be defined by derived classes
 		// Defaults to doing nothing
@@ -24,7 +83,11 @@ namespace ltbl {
 
 		void setQuadtree(QuadtreeOccupant* oc);
 
-		void recursiveCopy(QuadtreeNode* pThisNode, QuadtreeNode* pOtherNode, QuadtreeNode* pThisParent);
+		void markDirty(QuadtreeOccupant* oc);
+		void unmarkDirty(QuadtreeOccupant* oc);
+
+		// Forgets all dirty occupants without updating them
+		void clearDirty();
 
 	public:
 		size_t _minNumNodeOccupants;
@@ -33,25 +96,58 @@ namespace ltbl {
 
 		float _oversizeMultiplier;
 
+		// Off by default, so queries from many threads do not contend on the shared counters.
+		// Only change it while no queries run
+		bool _recordQueryStats;
+
 		Quadtree();
-		Quadtree(const Quadtree &other) {
-			*this = other;
-		}
 
 		virtual ~Quadtree() {}
 
-		void operator=(const Quadtree &other);
-
 		virtual void add(QuadtreeOccupant* oc) = 0;
 
 		void pruneDeadReferences();
 
-		void queryRegion(std::vector<QuadtreeOccupant*> &result, const sf::FloatRect &region);
-		void queryPoint(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p);
-		void queryShape(std::vector<QuadtreeOccupant*> &result, const sf::ConvexShape &shape);
+		// Repositions every occupant marked with quadtreeMarkDirty. Occupants are detached
+		// first, then re-added grouped by the node they go to, and subtrees left with too
+		// few occupants are merged once everything has settled
+		void updateDirtyOccupants();
+
+		size_t getNumDirtyOccupants() const {
+			return _dirtyOccupants.size();
+		}
+
+		virtual void queryRegion(std::vector<QuadtreeOccupant*> &result, const sf::FloatRect &region) const;
+		virtual void queryPoint(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p) const;
+		virtual void queryShape(std::vector<QuadtreeOccupant*> &result, const ShapeAxes &axes) const;
+
+		void queryShape(std::vector<QuadtreeOccupant*> &result, const sf::ConvexShape &shape) const {
+			queryShape(result, ShapeAxes(shape));
+		}
+
+		// Appends the k occupants whose AABBs are closest to p, nearest first. Best-first,
+		// nodes farther away than the k-th occupant are never opened
+		virtual void queryNearest(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p, size_t k) const;
+
+		// Finds the occupant whose AABB the ray enters first within maxDistance. Nodes are
+		// visited front to back, stopping at the first hit. direction does not need to be
+		// normalized, distance is measured in world units
+		virtual bool raycast(const sf::Vector2f &origin, const sf::Vector2f &direction, float maxDistance, QuadtreeOccupant* &hit, float &distance) const;
+
+		const QuadtreeNodePool::Stats &getNodePoolStats() const {
+			return _nodePool.getStats();
+		}
+
+		// Counters since the last resetStats, plus the current depth histogram, walked on
+		// every call. Query counters stay at zero unless _recordQueryStats is set, reading
+		// them while queries run gives a rough snapshot
+		virtual QuadtreeStats getStats() const;
+
+		void resetStats();
 
 		friend class QuadtreeNode;
 		friend class QuadtreeOccupant;
 		friend class SceneObject;
+		friend struct QuadtreeNodeDeleter;
 	};
 }
\ No newline at end of file
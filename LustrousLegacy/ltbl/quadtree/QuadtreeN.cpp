@@ -6,6 +6,10 @@
 
 using namespace ltbl;
 
+void QuadtreeNodeDeleter::operator()(QuadtreeNode* pNode) const {
+	pNode->_pQuadtree->_nodePool.destroy(pNode);
+}
+
 QuadtreeNode::QuadtreeNode(const sf::FloatRect &region, int level, QuadtreeNode* pParent, Quadtree* pQuadtree)
 : _hasChildren(false),
 _region(region), _level(level), _pParent(pParent), _pQuadtree(pQuadtree),
@@ -24,7 +28,7 @@ void QuadtreeNode::create(const sf::FloatRect &region, int level, QuadtreeNode*
 void QuadtreeNode::getPossibleOccupantPosition(QuadtreeOccupant* oc, sf::Vector2i &point) {
 	// Compare the center of the AABB of the occupant to that of this node to determine
 	// which child it may (possibly, not certainly) fit in
-	const sf::Vector2f &occupantCenter = rectCenter(oc->getAABB());
+	const sf::Vector2f &occupantCenter = rectCenter(oc->_quadtreeAABB);
 	const sf::Vector2f &nodeRegionCenter = rectCenter(_region);
 
 	point.x = occupantCenter.x > nodeRegionCenter.x ? 1 : 0;
@@ -34,14 +38,13 @@ void QuadtreeNode::getPossibleOccupantPosition(QuadtreeOccupant* oc, sf::Vector2
 void QuadtreeNode::addToThisLevel(QuadtreeOccupant* oc) {
 	oc->_pQuadtreeNode = this;
 
-	if (_occupants.find(oc) != _occupants.end())
-		return;
-
+	// Does nothing if already in this node
 	_occupants.insert(oc);
 }
 
-bool QuadtreeNode::addToChildren(QuadtreeOccupant* oc) {
-	assert(_hasChildren);
+QuadtreeNode* QuadtreeNode::getFittingChild(QuadtreeOccupant* oc) {
+	if (!_hasChildren)
+		return nullptr;
 
 	sf::Vector2i position;
 
@@ -50,7 +53,18 @@ bool QuadtreeNode::addToChildren(QuadtreeOccupant* oc) {
 	QuadtreeNode* pChild = _children[position.x + position.y * 2].get();
 
 	// See if the occupant fits in the child at the selected position
-	if (rectContains(pChild->_region, oc->getAABB())) {
+	if (rectContains(pChild->_region, oc->_quadtreeAABB))
+		return pChild;
+
+	return nullptr;
+}
+
+bool QuadtreeNode::addToChildren(QuadtreeOccupant* oc) {
+	assert(_hasChildren);
+
+	QuadtreeNode* pChild = getFittingChild(oc);
+
+	if (pChild != nullptr) {
 		// Fits, so can add to the child and finish
 		pChild->add(oc);
 
@@ -80,10 +94,12 @@ void QuadtreeNode::partition() {
 		sf::Vector2f center = rectCenter(childAABB);
 		childAABB = rectFromBounds(center - newHalfDims, center + newHalfDims);
 
-		_children[x + y * 2].reset(new QuadtreeNode(childAABB, nextLowerLevel, this, _pQuadtree));
+		_children[x + y * 2].reset(_pQuadtree->_nodePool.create(childAABB, nextLowerLevel, this, _pQuadtree));
 	}
 
 	_hasChildren = true;
+
+	_pQuadtree->_partitionCount++;
 }
 
 void QuadtreeNode::merge() {
@@ -92,22 +108,26 @@ void QuadtreeNode::merge() {
 		getOccupants(_occupants);
 
 		destroyChildren();
+
+		_pQuadtree->_mergeCount++;
 	}
 }
 
-void QuadtreeNode::getOccupants(std::unordered_set<QuadtreeOccupant*> &occupants) {
-	// Iteratively parse subnodes in order to collect all occupants below this node
-	std::list<QuadtreeNode*> open;
+void QuadtreeNode::getOccupants(QuadtreeOccupantList &occupants) {
+	// Iteratively parse subnodes in order to collect all occupants below this node.
+	// This node itself is skipped, occupants may be gathered into its own list
+	QuadtreeNodeStack open;
 
-	open.push_back(this);
+	if (_hasChildren)
+	for (int i = 0; i < 4; i++)
+		open.push(_children[i].get());
 
 	while (!open.empty()) {
 		// Depth-first (results in less memory usage), remove objects from open list
-		QuadtreeNode* pCurrent = open.back();
-		open.pop_back();
+		QuadtreeNode* pCurrent = open.pop();
 
 		// Get occupants
-		for (std::unordered_set<QuadtreeOccupant*>::iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
+		for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
 		if ((*it) != nullptr) {
 			// Assign new node
 			(*it)->_pQuadtreeNode = this;
@@ -119,23 +139,22 @@ void QuadtreeNode::getOccupants(std::unordered_set<QuadtreeOccupant*> &occupants
 		// If the node has children, add them to the open list
 		if (pCurrent->_hasChildren)
 		for (int i = 0; i < 4; i++)
-			open.push_back(pCurrent->_children[i].get());
+			open.push(pCurrent->_children[i].get());
 	}
 }
 
-void QuadtreeNode::removeForDeletion(std::unordered_set<QuadtreeOccupant*> &occupants) {
+void QuadtreeNode::removeForDeletion(QuadtreeOccupantList &occupants) {
 	// Iteratively parse subnodes in order to collect all occupants below this node
-	std::list<QuadtreeNode*> open;
+	QuadtreeNodeStack open;
 
-	open.push_back(this);
+	open.push(this);
 
 	while (!open.empty()) {
 		// Depth-first (results in less memory usage), remove objects from open list
-		QuadtreeNode* pCurrent = open.back();
-		open.pop_back();
+		QuadtreeNode* pCurrent = open.pop();
 
 		// Get occupants
-		for (std::unordered_set<QuadtreeOccupant*>::iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
+		for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
 		if ((*it) != nullptr) {
 			// Since will be deleted, remove the reference
 			(*it)->_pQuadtreeNode = nullptr;
@@ -147,23 +166,22 @@ void QuadtreeNode::removeForDeletion(std::unordered_set<QuadtreeOccupant*> &occu
 		// If the node has children, add them to the open list
 		if (pCurrent->_hasChildren)
 		for (int i = 0; i < 4; i++)
-			open.push_back(pCurrent->_children[i].get());
+			open.push(pCurrent->_children[i].get());
 	}
 }
 
 void QuadtreeNode::getAllOccupantsBelow(std::vector<QuadtreeOccupant*> &occupants) {
 	// Iteratively parse subnodes in order to collect all occupants below this node
-	std::list<QuadtreeNode*> open;
+	QuadtreeNodeStack open;
 
-	open.push_back(this);
+	open.push(this);
 
 	while (!open.empty()) {
 		// Depth-first (results in less memory usage), remove objects from open list
-		QuadtreeNode* pCurrent = open.back();
-		open.pop_back();
+		QuadtreeNode* pCurrent = open.pop();
 
 		// Get occupants
-		for (std::unordered_set<QuadtreeOccupant*>::iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
+		for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
 		if ((*it) != nullptr)
 			// Add to this node
 			occupants.push_back(*it);
@@ -171,31 +189,30 @@ void QuadtreeNode::getAllOccupantsBelow(std::vector<QuadtreeOccupant*> &occupant
 		// If the node has children, add them to the open list
 		if (pCurrent->_hasChildren)
 		for (int i = 0; i < 4; i++)
-			open.push_back(pCurrent->_children[i].get());
+			open.push(pCurrent->_children[i].get());
 	}
 }
 
 void QuadtreeNode::getAllOccupantsBelow(std::unordered_set<QuadtreeOccupant*> &occupants) {
 	// Iteratively parse subnodes in order to collect all occupants below this node
-	std::list<QuadtreeNode*> open;
+	QuadtreeNodeStack open;
 
-	open.push_back(this);
+	open.push(this);
 
 	while (!open.empty()) {
 		// Depth-first (results in less memory usage), remove objects from open list
-		QuadtreeNode* pCurrent = open.back();
-		open.pop_back();
+		QuadtreeNode* pCurrent = open.pop();
 
 		// Get occupants
-		for (std::unordered_set<QuadtreeOccupant*>::iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
-		if ((*it) == nullptr)
+		for (QuadtreeOccupantList::const_iterator it = pCurrent->_occupants.begin(); it != pCurrent->_occupants.end(); it++)
+		if ((*it) != nullptr)
 			// Add to this node
 			occupants.insert(*it);
 
 		// If the node has children, add them to the open list
 		if (pCurrent->_hasChildren)
 		for (int i = 0; i < 4; i++)
-			open.push_back(pCurrent->_children[i].get());
+			open.push(pCurrent->_children[i].get());
 	}
 }
 
@@ -203,9 +220,8 @@ void QuadtreeNode::update(QuadtreeOccupant* oc) {
 	if (oc == nullptr)
 		return;
 
-	if (!_occupants.empty())
-		// Remove, may be re-added to this node later
-		_occupants.erase(oc);
+	// Remove, may be re-added to this node later
+	_occupants.erase(oc);
 
 	// Propogate upwards, looking for a node that has room (the current one may still have room)
 	QuadtreeNode* pNode = this;
@@ -214,7 +230,7 @@ void QuadtreeNode::update(QuadtreeOccupant* oc) {
 		pNode->_numOccupantsBelow--;
 
 		// If has room for 1 more, found a spot
-		if (rectContains(pNode->_region, oc->getAABB()))
+		if (rectContains(pNode->_region, oc->_quadtreeAABB))
 			break;
 
 		pNode = pNode->_pParent;
@@ -224,9 +240,6 @@ void QuadtreeNode::update(QuadtreeOccupant* oc) {
 	if (pNode == nullptr) {
 		assert(_pQuadtree != nullptr);
 
-		if (_pQuadtree->_outsideRoot.find(oc) != _pQuadtree->_outsideRoot.end())
-			return;
-
 		_pQuadtree->_outsideRoot.insert(oc);
 
 		oc->_pQuadtreeNode = nullptr;
@@ -271,8 +284,10 @@ void QuadtreeNode::add(QuadtreeOccupant* oc) {
 			return; // Fit, can stop
 	}
 	else {
-		// Check if we need a new partition
-		if (static_cast<signed>(_occupants.size()) >= _pQuadtree->_maxNumNodeOccupants && _level < _pQuadtree->_maxLevels) {
+		// Check if we need a new partition. Levels count down from the root, so the depth of
+		// this node is its distance from the root's level
+		if (static_cast<signed>(_occupants.size()) >= _pQuadtree->_maxNumNodeOccupants &&
+			_pQuadtree->_pRootNode->_level - _level < static_cast<int>(_pQuadtree->_maxLevels) - 1) {
 			partition();
 
 			if (addToChildren(oc))
@@ -285,14 +300,6 @@ void QuadtreeNode::add(QuadtreeOccupant* oc) {
 }
 
 void QuadtreeNode::pruneDeadReferences() {
-	for (std::unordered_set<QuadtreeOccupant*>::iterator it = _occupants.begin(); it != _occupants.end();) {
-		if ((*it) == nullptr)
-			it++;
-		else
-			it = _occupants.erase(it);
-	}
-
-	if (_hasChildren)
-	for (int i = 0; i < 4; i++)
-		_children[i]->pruneDeadReferences();
+	// Occupants are swapped out of their list as soon as they are removed,
+	// so there are never dead references left to prune
 }
\ No newline at end of file
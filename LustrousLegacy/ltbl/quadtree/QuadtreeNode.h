@@ -4,9 +4,20 @@
 
 #include <memory>
 #include <array>
+#include <vector>
+#include <algorithm>
 #include <unordered_set>
 
 namespace ltbl {
+	class QuadtreeNode;
+
+	// Returns a node to the pool of the quadtree it belongs to
+	struct QuadtreeNodeDeleter {
+		void operator()(QuadtreeNode* pNode) const;
+	};
+
+	typedef std::unique_ptr<QuadtreeNode, QuadtreeNodeDeleter> QuadtreeNodePtr;
+
 	class QuadtreeNode : public sf::NonCopyable {
 	private:
 		QuadtreeNode* _pParent;
@@ -14,9 +25,9 @@ namespace ltbl {
 
 		bool _hasChildren;
 
-		std::array<std::unique_ptr<QuadtreeNode>, 4> _children;
+		std::array<QuadtreeNodePtr, 4> _children;
 
-		std::unordered_set<QuadtreeOccupant*> _occupants;
+		QuadtreeOccupantList _occupants;
 
 		sf::FloatRect _region;
 
@@ -26,6 +37,9 @@ namespace ltbl {
 
 		void getPossibleOccupantPosition(QuadtreeOccupant* oc, sf::Vector2i &point);
 
+		// Returns the child the occupant would be added to, or nullptr if it stays at this level
+		QuadtreeNode* getFittingChild(QuadtreeOccupant* oc);
+
 		void addToThisLevel(QuadtreeOccupant* oc);
 
 		// Returns true if occupant was added to children
@@ -38,7 +52,8 @@ namespace ltbl {
 			_hasChildren = false;
 		}
 
-		void getOccupants(std::unordered_set<QuadtreeOccupant*> &occupants);
+		// Collects the occupants of all nodes below this one, reassigning them to this node
+		void getOccupants(QuadtreeOccupantList &occupants);
 
 		void partition();
 
@@ -47,11 +62,11 @@ namespace ltbl {
 		void update(QuadtreeOccupant* oc);
 		void remove(QuadtreeOccupant* oc);
 
-		void removeForDeletion(std::unordered_set<QuadtreeOccupant*> &occupants);
+		void removeForDeletion(QuadtreeOccupantList &occupants);
 
 	public:
 		QuadtreeNode()
-			: _hasChildren(false), _numOccupantsBelow(0)
+			: _pParent(nullptr), _pQuadtree(nullptr), _hasChildren(false), _numOccupantsBelow(0)
 		{}
 
 		QuadtreeNode(const sf::FloatRect &region, int level, QuadtreeNode* pParent, class Quadtree* pQuadtree);
@@ -81,5 +96,112 @@ namespace ltbl {
 		friend class QuadtreeOccupant;
 		friend class Quadtree;
 		friend class DynamicQuadtree;
+		friend struct QuadtreeNodeDeleter;
+	};
+
+	// Open list for depth-first traversals. Each node pushes at most 4 children, so
+	// 3 entries per level plus the root covers the default _maxLevels without touching
+	// the heap. Deeper traversals spill into an overflow vector
+	class QuadtreeNodeStack : public sf::NonCopyable {
+	private:
+		static const size_t _inlineCapacity = 128;
+
+		std::array<QuadtreeNode*, _inlineCapacity> _inline;
+		std::vector<QuadtreeNode*> _overflow;
+
+		size_t _size;
+
+	public:
+		QuadtreeNodeStack()
+			: _size(0)
+		{}
+
+		void push(QuadtreeNode* pNode) {
+			if (_size < _inlineCapacity)
+				_inline[_size] = pNode;
+			else
+				_overflow.push_back(pNode);
+
+			_size++;
+		}
+
+		QuadtreeNode* pop() {
+			_size--;
+
+			if (_size < _inlineCapacity)
+				return _inline[_size];
+
+			QuadtreeNode* pNode = _overflow.back();
+			_overflow.pop_back();
+
+			return pNode;
+		}
+
+		bool empty() const {
+			return _size == 0;
+		}
+	};
+
+	// Open list for best-first traversals, pops the item with the smallest _distance.
+	// Like QuadtreeNodeStack it starts out inline and spills into a vector when full
+	template<class Item>
+	class QuadtreeSearchQueue : public sf::NonCopyable {
+	private:
+		static const size_t _inlineCapacity = 64;
+
+		std::array<Item, _inlineCapacity> _inline;
+		std::vector<Item> _overflow;
+
+		Item* _pItems;
+		size_t _size;
+
+		static bool farther(const Item &left, const Item &right) {
+			return left._distance > right._distance;
+		}
+
+	public:
+		// _inline is left uninitialized, so its address is only taken in the body
+		QuadtreeSearchQueue()
+			: _size(0)
+		{
+			_pItems = _inline.data();
+		}
+
+		void push(const Item &item) {
+			if (_pItems == _inline.data() && _size < _inlineCapacity)
+				_inline[_size] = item;
+			else {
+				if (_pItems == _inline.data())
+					_overflow.assign(_inline.begin(), _inline.end());
+
+				_overflow.push_back(item);
+				_pItems = _overflow.data();
+			}
+
+			_size++;
+
+			std::push_heap(_pItems, _pItems + _size, farther);
+		}
+
+		Item pop() {
+			std::pop_heap(_pItems, _pItems + _size, farther);
+
+			_size--;
+
+			Item item = _pItems[_size];
+
+			if (_pItems != _inline.data())
+				_overflow.pop_back();
+
+			return item;
+		}
+
+		const Item &top() const {
+			return _pItems[0];
+		}
+
+		bool empty() const {
+			return _size == 0;
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include <ltbl/quadtree/QuadtreeNodePool.h>
+
+#include <assert.h>
+
+using namespace ltbl;
+
+void* QuadtreeNodePool::allocate() {
+	Slot* pSlot;
+
+	if (_pFree != nullptr) {
+		pSlot = _pFree;
+		_pFree = _pFree->_pNextFree;
+
+		_stats._recycledNodes++;
+	}
+	else {
+		if (_unusedInBlock == 0) {
+			_blocks.push_back(std::unique_ptr<Slot[]>(new Slot[_nodesPerBlock]));
+			_unusedInBlock = _nodesPerBlock;
+
+			_stats._reservedNodes += _nodesPerBlock;
+		}
+
+		pSlot = &_blocks.back()[_nodesPerBlock - _unusedInBlock];
+		_unusedInBlock--;
+	}
+
+	_stats._liveNodes++;
+
+	if (_stats._liveNodes > _stats._peakNodes)
+		_stats._peakNodes = _stats._liveNodes;
+
+	return &pSlot->_storage;
+}
+
+void QuadtreeNodePool::destroy(QuadtreeNode* pNode) {
+	if (pNode == nullptr)
+		return;
+
+	assert(_stats._liveNodes > 0);
+
+	// Children are returned to the pool by the node's destructor
+	pNode->~QuadtreeNode();
+
+	Slot* pSlot = reinterpret_cast<Slot*>(pNode);
+	pSlot->_pNextFree = _pFree;
+	_pFree = pSlot;
+
+	_stats._liveNodes--;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <ltbl/quadtree/QuadtreeNode.h>
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace ltbl {
+	// Free-list arena for the nodes of one quadtree. Storage is reserved in blocks
+	// holding a whole number of 4-node partitions, released nodes are recycled LIFO
+	// so a merge followed by a partition reuses the same memory
+	class QuadtreeNodePool : public sf::NonCopyable {
+	public:
+		struct Stats {
+			size_t _liveNodes;
+			size_t _peakNodes;
+			size_t _recycledNodes;
+			size_t _reservedNodes;
+
+			Stats()
+				: _liveNodes(0), _peakNodes(0), _recycledNodes(0), _reservedNodes(0)
+			{}
+		};
+
+	private:
+		static const size_t _nodesPerBlock = 4 * 16;
+
+		union Slot {
+			Slot* _pNextFree;
+			std::aligned_storage<sizeof(QuadtreeNode), alignof(QuadtreeNode)>::type _storage;
+		};
+
+		std::vector<std::unique_ptr<Slot[]>> _blocks;
+
+		// Slots released by destroy
+		Slot* _pFree;
+
+		// Slots of the newest block that were never handed out
+		size_t _unusedInBlock;
+
+		Stats _stats;
+
+		void* allocate();
+
+	public:
+		QuadtreeNodePool()
+			: _pFree(nullptr), _unusedInBlock(0)
+		{}
+
+		template<class ... Args>
+		QuadtreeNode* create(Args && ... args) {
+			return new (allocate()) QuadtreeNode(std::forward<Args>(args)...);
+		}
+
+		// Destroys the node (and with it any children) and recycles its slot
+		void destroy(QuadtreeNode* pNode);
+
+		const Stats &getStats() const {
+			return _stats;
+		}
+	};
+}
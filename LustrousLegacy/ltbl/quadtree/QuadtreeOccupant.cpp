@@ -9,6 +9,8 @@
 using namespace ltbl;
 
 void QuadtreeOccupant::quadtreeUpdate() {
+	_quadtreeAABB = getAABB();
+
 	if (_pQuadtreeNode != nullptr)
 		_pQuadtreeNode->update(this);
 	else {
@@ -19,8 +21,16 @@ void QuadtreeOccupant::quadtreeUpdate() {
 }
 
 void QuadtreeOccupant::quadtreeRemove() {
+	_pQuadtree->unmarkDirty(this);
+
 	if (_pQuadtreeNode != nullptr)
 		_pQuadtreeNode->remove(this);
 	else
 		_pQuadtree->_outsideRoot.erase(this);
+}
+
+void QuadtreeOccupant::quadtreeMarkDirty() {
+	assert(_pQuadtree != nullptr);
+
+	_pQuadtree->markDirty(this);
 }
\ No newline at end of file
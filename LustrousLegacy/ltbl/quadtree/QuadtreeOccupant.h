@@ -7,7 +7,7 @@
 
 #include <memory>
 #include <array>
-#include <unordered_set>
+#include <vector>
 
 namespace ltbl {
 	class QuadtreeOccupant {
@@ -15,19 +15,99 @@ namespace ltbl {
 		class QuadtreeNode* _pQuadtreeNode;
 		class Quadtree* _pQuadtree;
 
+		// Index in the occupant list currently holding this occupant
+		size_t _quadtreeSlot;
+
+		// getAABB() as of the last add or quadtreeUpdate, read by all tree traversals
+		sf::FloatRect _quadtreeAABB;
+
+		// Set while waiting in the dirty list of the tree, at index _quadtreeDirtySlot
+		bool _quadtreeDirty;
+		size_t _quadtreeDirtySlot;
+
 	public:
 		QuadtreeOccupant()
-			: _pQuadtreeNode(nullptr), _pQuadtree(nullptr)
+			: _pQuadtreeNode(nullptr), _pQuadtree(nullptr), _quadtreeSlot(0), _quadtreeDirty(false), _quadtreeDirtySlot(0)
 		{}
 
+		// Refreshes the cached AABB and repositions the occupant in its tree
 		void quadtreeUpdate();
 		void quadtreeRemove();
 
+		// Defers quadtreeUpdate until the tree applies all dirty occupants at once
+		// with Quadtree::updateDirtyOccupants. Marking twice does nothing
+		void quadtreeMarkDirty();
+
 		virtual sf::FloatRect getAABB() const = 0;
 
+		const sf::FloatRect &getQuadtreeAABB() const {
+			return _quadtreeAABB;
+		}
+
 		friend class Quadtree;
 		friend class QuadtreeNode;
+		friend class QuadtreeOccupantList;
 		friend class DynamicQuadtree;
 		friend class StaticQuadtree;
 	};
-}
\ No newline at end of file
+
+	// Contiguous list of occupants. An occupant lives in at most one list at a time
+	// and remembers its slot, so lookup and removal are O(1) (swap-and-pop)
+	class QuadtreeOccupantList {
+	private:
+		std::vector<QuadtreeOccupant*> _occupants;
+
+	public:
+		typedef std::vector<QuadtreeOccupant*>::const_iterator const_iterator;
+
+		bool contains(const QuadtreeOccupant* oc) const {
+			return oc->_quadtreeSlot < _occupants.size() && _occupants[oc->_quadtreeSlot] == oc;
+		}
+
+		// Does nothing if already in the list
+		void insert(QuadtreeOccupant* oc) {
+			if (contains(oc))
+				return;
+
+			oc->_quadtreeSlot = _occupants.size();
+			_occupants.push_back(oc);
+		}
+
+		// Does nothing if not in the list
+		void erase(QuadtreeOccupant* oc) {
+			if (!contains(oc))
+				return;
+
+			QuadtreeOccupant* pLast = _occupants.back();
+
+			_occupants[oc->_quadtreeSlot] = pLast;
+			pLast->_quadtreeSlot = oc->_quadtreeSlot;
+
+			_occupants.pop_back();
+		}
+
+		void clear() {
+			_occupants.clear();
+		}
+
+		size_t size() const {
+			return _occupants.size();
+		}
+
+		bool empty() const {
+			return _occupants.empty();
+		}
+
+		QuadtreeOccupant* operator[](size_t index) const {
+			return _occupants[index];
+		}
+
+		const_iterator begin() const {
+			return _occupants.begin();
+		}
+
+		const_iterator end() const {
+			return _occupants.end();
+		}
+	};
+}
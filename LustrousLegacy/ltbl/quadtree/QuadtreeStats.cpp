@@ -0,0 +1,47 @@
+#include <ltbl/quadtree/QuadtreeStats.h>
+
+#include <sstream>
+
+using namespace ltbl;
+
+void QuadtreeStats::addNodeAtDepth(size_t depth, size_t numOccupants) {
+	if (_nodesAtDepth.size() <= depth) {
+		_nodesAtDepth.resize(depth + 1, 0);
+		_occupantsAtDepth.resize(depth + 1, 0);
+	}
+
+	_nodesAtDepth[depth]++;
+	_occupantsAtDepth[depth] += numOccupants;
+}
+
+std::string QuadtreeStats::toJson() const {
+	std::ostringstream json;
+
+	json << "{\"queries\":" << _queries
+		<< ",\"nodesVisited\":" << _nodesVisited
+		<< ",\"occupantsTested\":" << _occupantsTested
+		<< ",\"occupantsReturned\":" << _occupantsReturned
+		<< ",\"partitions\":" << _partitions
+		<< ",\"merges\":" << _merges
+		<< ",\"expands\":" << _expands
+		<< ",\"contracts\":" << _contracts
+		<< ",\"outsideRoot\":" << _outsideRoot;
+
+	json << ",\"nodesAtDepth\":[";
+
+	for (size_t i = 0; i < _nodesAtDepth.size(); i++)
+		json << (i == 0 ? "" : ",") << _nodesAtDepth[i];
+
+	json << "],\"occupantsAtDepth\":[";
+
+	for (size_t i = 0; i < _occupantsAtDepth.size(); i++)
+		json << (i == 0 ? "" : ",") << _occupantsAtDepth[i];
+
+	json << "],\"nodePool\":{\"liveNodes\":" << _nodePool._liveNodes
+		<< ",\"peakNodes\":" << _nodePool._peakNodes
+		<< ",\"recycledNodes\":" << _nodePool._recycledNodes
+		<< ",\"reservedNodes\":" << _nodePool._reservedNodes
+		<< "}}";
+
+	return json.str();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <ltbl/quadtree/QuadtreeNodePool.h>
+
+#include <string>
+#include <vector>
+
+namespace ltbl {
+	// Snapshot of the counters and the current shape of a quadtree, see Quadtree::getStats
+	struct QuadtreeStats {
+		// Queries of any kind since the last Quadtree::resetStats, while Quadtree::_recordQueryStats is set
+		size_t _queries;
+		size_t _nodesVisited;
+		size_t _occupantsTested;
+		size_t _occupantsReturned;
+
+		// Structure changes since the last Quadtree::resetStats
+		size_t _partitions;
+		size_t _merges;
+		size_t _expands;
+		size_t _contracts;
+
+		// Current shape, indexed by depth below the root (0 is the root)
+		std::vector<size_t> _nodesAtDepth;
+		std::vector<size_t> _occupantsAtDepth;
+
+		size_t _outsideRoot;
+
+		QuadtreeNodePool::Stats _nodePool;
+
+		QuadtreeStats()
+			: _queries(0), _nodesVisited(0), _occupantsTested(0), _occupantsReturned(0),
+			_partitions(0), _merges(0), _expands(0), _contracts(0), _outsideRoot(0)
+		{}
+
+		// Counts the node or occupants at the given depth, growing the histograms as needed
+		void addNodeAtDepth(size_t depth, size_t numOccupants);
+
+		std::string toJson() const;
+	};
+}
@@ -1,17 +1,524 @@
 #include <ltbl/quadtree/StaticQuadtree.h>
 
+#include <algorithm>
+
 #include <assert.h>
 
 using namespace ltbl;
 
+// Spreads the low 16 bits of a cell coordinate to the even bits of a Morton code
+static std::uint64_t mortonSpread(unsigned int coordinate) {
+	std::uint64_t bits = coordinate & 0xffff;
+
+	bits = (bits | (bits << 8)) & 0x00ff00ff;
+	bits = (bits | (bits << 4)) & 0x0f0f0f0f;
+	bits = (bits | (bits << 2)) & 0x33333333;
+	bits = (bits | (bits << 1)) & 0x55555555;
+
+	return bits;
+}
+
 void StaticQuadtree::add(QuadtreeOccupant* oc) {
 	assert(created());
 
 	setQuadtree(oc);
 
+	oc->_quadtreeAABB = oc->getAABB();
+
 	// If the occupant fits in the root node
-	if (rectContains(_pRootNode->getRegion(), oc->getAABB()))
+	if (rectContains(_pRootNode->getRegion(), oc->_quadtreeAABB))
 		_pRootNode->add(oc);
 	else
 		_outsideRoot.insert(oc);
+}
+
+void StaticQuadtree::clearBulk() {
+	// Only take out the previous build's occupants, so a rebuild never lists one twice
+	for (size_t i = 0; i < _bulkOutsideRoot.size(); i++)
+		_outsideRoot.erase(_bulkOutsideRoot[i]);
+
+	_bulkOutsideRoot.clear();
+	_bulkNodes.clear();
+	_bulkOccupants.clear();
+	_bulkAABBs.clear();
+}
+
+void StaticQuadtree::buildFromInput() {
+	clearBulk();
+	_buildEntries.clear();
+	_buildEntries.reserve(_buildInput.size());
+
+	if (!created()) {
+		sf::FloatRect rootRegion;
+
+		for (size_t i = 0; i < _buildInput.size(); i++) {
+			sf::FloatRect aabb = _buildInput[i]->getAABB();
+
+			if (i == 0)
+				rootRegion = aabb;
+			else
+				rootRegion = rectExpand(rectExpand(rootRegion, rectLowerBound(aabb)), rectUpperBound(aabb));
+		}
+
+		create(rootRegion);
+	}
+
+	// Cells of the deepest level, limited to 16 bits per axis
+	const int maxLevel = static_cast<int>(std::min<size_t>(_maxLevels, 16));
+	const unsigned int numCells = 1u << maxLevel;
+
+	const sf::FloatRect &rootRegion = _pRootNode->getRegion();
+
+	sf::Vector2f cellScale(rootRegion.width > 0.0f ? numCells / rootRegion.width : 0.0f, rootRegion.height > 0.0f ? numCells / rootRegion.height : 0.0f);
+
+	sf::Vector2f rootLowerBound = rectLowerBound(rootRegion);
+	sf::Vector2f rootUpperBound = rectUpperBound(rootRegion);
+
+	for (size_t i = 0; i < _buildInput.size(); i++) {
+		QuadtreeOccupant* oc = _buildInput[i];
+
+		setQuadtree(oc);
+
+		sf::FloatRect aabb = oc->getAABB();
+
+		oc->_pQuadtreeNode = nullptr;
+		oc->_quadtreeAABB = aabb;
+
+		sf::Vector2f lowerBound(aabb.left, aabb.top);
+		sf::Vector2f upperBound(aabb.left + aabb.width, aabb.top + aabb.height);
+
+		// rectContains, on the bounds that are needed below anyway
+		if (lowerBound.x < rootLowerBound.x || lowerBound.y < rootLowerBound.y ||
+			upperBound.x > rootUpperBound.x || upperBound.y > rootUpperBound.y) {
+			_outsideRoot.insert(oc);
+			_bulkOutsideRoot.push_back(oc);
+
+			continue;
+		}
+
+		// Cells holding the corners of the AABB
+		unsigned int lowerX = std::min(static_cast<unsigned int>((lowerBound.x - rootLowerBound.x) * cellScale.x), numCells - 1);
+		unsigned int lowerY = std::min(static_cast<unsigned int>((lowerBound.y - rootLowerBound.y) * cellScale.y), numCells - 1);
+		unsigned int upperX = std::min(static_cast<unsigned int>((upperBound.x - rootLowerBound.x) * cellScale.x), numCells - 1);
+		unsigned int upperY = std::min(static_cast<unsigned int>((upperBound.y - rootLowerBound.y) * cellScale.y), numCells - 1);
+
+		// The occupant belongs to the deepest node holding both corners, one level up for
+		// every bit the corner cells differ in
+		int levelsUp = 0;
+
+		for (unsigned int difference = (lowerX ^ upperX) | (lowerY ^ upperY); difference != 0; difference >>= 1)
+			levelsUp++;
+
+		int level = maxLevel - levelsUp;
+
+		std::uint64_t nodeCode = mortonSpread(lowerX >> levelsUp << levelsUp) | (mortonSpread(lowerY >> levelsUp << levelsUp) << 1);
+
+		// Sorting by code then level puts every node right before its children, with its
+		// own occupants first
+		BulkEntry entry;
+		entry._key = (nodeCode << 8) | level;
+		entry._input = i;
+
+		_buildEntries.push_back(entry);
+	}
+
+	sortBuildEntries(8 + 2 * maxLevel);
+
+	_bulkOccupants.resize(_buildEntries.size());
+	_bulkAABBs.resize(_buildEntries.size());
+
+	for (size_t i = 0; i < _buildEntries.size(); i++) {
+		_bulkOccupants[i] = _buildInput[_buildEntries[i]._input];
+		_bulkAABBs[i] = _bulkOccupants[i]->_quadtreeAABB;
+	}
+
+	_bulkNodes.reserve(_buildEntries.size() / 2);
+
+	if (!_buildEntries.empty())
+		buildNode(0, _buildEntries.size(), 0, maxLevel);
+}
+
+void StaticQuadtree::sortBuildEntries(int keyBits) {
+	// Radix sort, a byte of the key per pass starting from the lowest. Keys are short and
+	// many share their high bytes, which makes this much cheaper than comparing them
+	if (_buildEntries.empty())
+		return;
+
+	const int numPasses = (keyBits + 7) / 8;
+
+	std::vector<size_t> counts(numPasses * 256, 0);
+
+	for (size_t i = 0; i < _buildEntries.size(); i++)
+	for (int pass = 0; pass < numPasses; pass++)
+		counts[pass * 256 + ((_buildEntries[i]._key >> (8 * pass)) & 0xff)]++;
+
+	_buildSortBuffer.resize(_buildEntries.size());
+
+	for (int pass = 0; pass < numPasses; pass++) {
+		size_t* passCounts = &counts[pass * 256];
+
+		// All keys share this byte, the order stays as it is
+		if (passCounts[(_buildEntries[0]._key >> (8 * pass)) & 0xff] == _buildEntries.size())
+			continue;
+
+		size_t offset = 0;
+
+		for (int digit = 0; digit < 256; digit++) {
+			size_t count = passCounts[digit];
+
+			passCounts[digit] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < _buildEntries.size(); i++)
+			_buildSortBuffer[passCounts[(_buildEntries[i]._key >> (8 * pass)) & 0xff]++] = _buildEntries[i];
+
+		_buildEntries.swap(_buildSortBuffer);
+	}
+}
+
+size_t StaticQuadtree::buildNode(size_t begin, size_t end, int level, int maxLevel) {
+	const std::uint64_t levelMask = 0xff;
+
+	size_t count = end - begin;
+
+	// Skip levels that would only hold a single child
+	while (count > _maxNumNodeOccupants && level < maxLevel) {
+		int childShift = 8 + 2 * (maxLevel - level - 1);
+
+		if (static_cast<int>(_buildEntries[begin]._key & levelMask) == level ||
+			((_buildEntries[begin]._key >> childShift) & 3) != ((_buildEntries[end - 1]._key >> childShift) & 3))
+			break;
+
+		level++;
+	}
+
+	size_t index = _bulkNodes.size();
+
+	BulkNode node;
+	node._firstOccupant = begin;
+	node._numOccupants = count;
+
+	// Small enough, or as deep as the codes go, so keep everything here
+	size_t childrenBegin = end;
+
+	if (count > _maxNumNodeOccupants && level < maxLevel) {
+		childrenBegin = begin;
+
+		while (childrenBegin < end && static_cast<int>(_buildEntries[childrenBegin]._key & levelMask) == level)
+			childrenBegin++;
+
+		node._numOccupants = childrenBegin - begin;
+	}
+
+	_bulkNodes.push_back(node);
+
+	sf::Vector2f lowerBound;
+	sf::Vector2f upperBound;
+
+	bool hasBounds = false;
+
+	for (size_t i = begin; i < childrenBegin; i++) {
+		sf::Vector2f occupantLowerBound = rectLowerBound(_bulkAABBs[i]);
+		sf::Vector2f occupantUpperBound = rectUpperBound(_bulkAABBs[i]);
+
+		if (!hasBounds) {
+			lowerBound = occupantLowerBound;
+			upperBound = occupantUpperBound;
+
+			hasBounds = true;
+		}
+		else {
+			lowerBound.x = std::min(lowerBound.x, occupantLowerBound.x);
+			lowerBound.y = std::min(lowerBound.y, occupantLowerBound.y);
+			upperBound.x = std::max(upperBound.x, occupantUpperBound.x);
+			upperBound.y = std::max(upperBound.y, occupantUpperBound.y);
+		}
+	}
+
+	// Children are runs of entries sharing the next 2 bits of the code. The bounds of a
+	// node are only known once its children are built
+	int childShift = 8 + 2 * (maxLevel - level - 1);
+
+	for (size_t childBegin = childrenBegin; childBegin < end;) {
+		std::uint64_t quadrant = (_buildEntries[childBegin]._key >> childShift) & 3;
+
+		size_t childEnd = childBegin + 1;
+
+		while (childEnd < end && ((_buildEntries[childEnd]._key >> childShift) & 3) == quadrant)
+			childEnd++;
+
+		size_t childIndex = buildNode(childBegin, childEnd, level + 1, maxLevel);
+
+		const BulkNode &child = _bulkNodes[childIndex];
+
+		if (!hasBounds) {
+			lowerBound = child._lowerBound;
+			upperBound = child._upperBound;
+
+			hasBounds = true;
+		}
+		else {
+			lowerBound.x = std::min(lowerBound.x, child._lowerBound.x);
+			lowerBound.y = std::min(lowerBound.y, child._lowerBound.y);
+			upperBound.x = std::max(upperBound.x, child._upperBound.x);
+			upperBound.y = std::max(upperBound.y, child._upperBound.y);
+		}
+
+		childBegin = childEnd;
+	}
+
+	_bulkNodes[index]._lowerBound = lowerBound;
+	_bulkNodes[index]._upperBound = upperBound;
+	_bulkNodes[index]._subtreeEnd = _bulkNodes.size();
+
+	return index;
+}
+
+void StaticQuadtree::queryRegion(std::vector<QuadtreeOccupant*> &result, const sf::FloatRect &region) const {
+	Quadtree::queryRegion(result, region);
+
+	// The node tree counted the query, only add the bulk-loaded part
+	size_t firstResult = result.size();
+	size_t nodesVisited = 0;
+	size_t occupantsTested = 0;
+
+	sf::Vector2f regionLowerBound = rectLowerBound(region);
+	sf::Vector2f regionUpperBound = rectUpperBound(region);
+
+	// Walk the nodes in order, jumping over the subtrees the region misses
+	for (size_t i = 0; i < _bulkNodes.size();) {
+		const BulkNode &node = _bulkNodes[i];
+
+		nodesVisited++;
+
+		if (regionLowerBound.x > node._upperBound.x || regionUpperBound.x < node._lowerBound.x ||
+			regionLowerBound.y > node._upperBound.y || regionUpperBound.y < node._lowerBound.y) {
+			i = node._subtreeEnd;
+
+			continue;
+		}
+
+		occupantsTested += node._numOccupants;
+
+		for (size_t j = node._firstOccupant; j < node._firstOccupant + node._numOccupants; j++)
+		if (region.intersects(_bulkAABBs[j]))
+			result.push_back(_bulkOccupants[j]);
+
+		i++;
+	}
+
+	recordQuery(0, nodesVisited, occupantsTested, result.size() - firstResult);
+}
+
+void StaticQuadtree::queryPoint(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p) const {
+	Quadtree::queryPoint(result, p);
+
+	// The node tree counted the query, only add the bulk-loaded part
+	size_t firstResult = result.size();
+	size_t nodesVisited = 0;
+	size_t occupantsTested = 0;
+
+	for (size_t i = 0; i < _bulkNodes.size();) {
+		const BulkNode &node = _bulkNodes[i];
+
+		nodesVisited++;
+
+		if (p.x < node._lowerBound.x || p.x > node._upperBound.x ||
+			p.y < node._lowerBound.y || p.y > node._upperBound.y) {
+			i = node._subtreeEnd;
+
+			continue;
+		}
+
+		occupantsTested += node._numOccupants;
+
+		for (size_t j = node._firstOccupant; j < node._firstOccupant + node._numOccupants; j++)
+		if (_bulkAABBs[j].contains(p))
+			result.push_back(_bulkOccupants[j]);
+
+		i++;
+	}
+
+	recordQuery(0, nodesVisited, occupantsTested, result.size() - firstResult);
+}
+
+void StaticQuadtree::queryShape(std::vector<QuadtreeOccupant*> &result, const ShapeAxes &axes) const {
+	Quadtree::queryShape(result, axes);
+
+	// The node tree counted the query, only add the bulk-loaded part
+	size_t firstResult = result.size();
+	size_t nodesVisited = 0;
+	size_t occupantsTested = 0;
+
+	for (size_t i = 0; i < _bulkNodes.size();) {
+		const BulkNode &node = _bulkNodes[i];
+
+		nodesVisited++;
+
+		if (!axes.intersects(rectFromBounds(node._lowerBound, node._upperBound))) {
+			i = node._subtreeEnd;
+
+			continue;
+		}
+
+		occupantsTested += node._numOccupants;
+
+		for (size_t j = node._firstOccupant; j < node._firstOccupant + node._numOccupants; j++)
+		if (axes.intersects(_bulkAABBs[j]))
+			result.push_back(_bulkOccupants[j]);
+
+		i++;
+	}
+
+	recordQuery(0, nodesVisited, occupantsTested, result.size() - firstResult);
+}
+
+void StaticQuadtree::queryNearest(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p, size_t k) const {
+	size_t firstResult = result.size();
+
+	Quadtree::queryNearest(result, p, k);
+
+	if (k == 0 || _bulkNodes.empty())
+		return;
+
+	size_t firstBulkResult = result.size();
+
+	QuadtreeSearchQueue<BulkSearchItem> open;
+
+	BulkSearchItem root = { rectDistanceSquared(rectFromBounds(_bulkNodes[0]._lowerBound, _bulkNodes[0]._upperBound), p), 0, true };
+
+	open.push(root);
+
+	size_t found = 0;
+	size_t nodesVisited = 0;
+	size_t occupantsTested = 0;
+
+	while (!open.empty() && found < k) {
+		BulkSearchItem current = open.pop();
+
+		if (!current._isNode) {
+			result.push_back(_bulkOccupants[current._index]);
+
+			found++;
+
+			continue;
+		}
+
+		const BulkNode &node = _bulkNodes[current._index];
+
+		nodesVisited++;
+		occupantsTested += node._numOccupants;
+
+		for (size_t j = node._firstOccupant; j < node._firstOccupant + node._numOccupants; j++) {
+			BulkSearchItem item = { rectDistanceSquared(_bulkAABBs[j], p), j, false };
+
+			open.push(item);
+		}
+
+		// Children follow their parent, each one ends where the next begins
+		for (size_t child = current._index + 1; child < node._subtreeEnd; child = _bulkNodes[child]._subtreeEnd) {
+			BulkSearchItem item = { rectDistanceSquared(rectFromBounds(_bulkNodes[child]._lowerBound, _bulkNodes[child]._upperBound), p), child, true };
+
+			open.push(item);
+		}
+	}
+
+	// Both runs are sorted, keep the k nearest of the two
+	if (firstBulkResult != firstResult) {
+		std::sort(result.begin() + firstResult, result.end(), [&p](QuadtreeOccupant* left, QuadtreeOccupant* right) {
+			return rectDistanceSquared(left->_quadtreeAABB, p) < rectDistanceSquared(right->_quadtreeAABB, p);
+		});
+
+		result.resize(std::min(result.size(), firstResult + k));
+	}
+
+	// The node tree already counted what it returned
+	recordQuery(0, nodesVisited, occupantsTested, result.size() - firstBulkResult);
+}
+
+bool StaticQuadtree::raycast(const sf::Vector2f &origin, const sf::Vector2f &direction, float maxDistance, QuadtreeOccupant* &hit, float &distance) const {
+	// Anything in the bulk-loaded tree has to be entered before the hit in the node tree
+	bool found = Quadtree::raycast(origin, direction, maxDistance, hit, distance);
+
+	if (found)
+		maxDistance = distance;
+
+	float length = vectorMagnitude(direction);
+
+	if (length == 0.0f || _bulkNodes.empty())
+		return found;
+
+	sf::Vector2f unitDirection = direction / length;
+
+	QuadtreeSearchQueue<BulkSearchItem> open;
+
+	float entryDistance;
+
+	size_t nodesVisited = 0;
+	size_t occupantsTested = 0;
+
+	if (rayRectIntersect(origin, unitDirection, maxDistance, rectFromBounds(_bulkNodes[0]._lowerBound, _bulkNodes[0]._upperBound), entryDistance)) {
+		BulkSearchItem root = { entryDistance, 0, true };
+
+		open.push(root);
+	}
+
+	while (!open.empty()) {
+		BulkSearchItem current = open.pop();
+
+		if (!current._isNode) {
+			// Only a strictly closer hit replaces the one from the node tree
+			if (!found || current._distance < distance) {
+				hit = _bulkOccupants[current._index];
+				distance = current._distance;
+			}
+
+			recordQuery(0, nodesVisited, occupantsTested, found ? 0 : 1);
+
+			return true;
+		}
+
+		const BulkNode &node = _bulkNodes[current._index];
+
+		nodesVisited++;
+		occupantsTested += node._numOccupants;
+
+		for (size_t j = node._firstOccupant; j < node._firstOccupant + node._numOccupants; j++)
+		if (rayRectIntersect(origin, unitDirection, maxDistance, _bulkAABBs[j], entryDistance)) {
+			BulkSearchItem item = { entryDistance, j, false };
+
+			open.push(item);
+		}
+
+		for (size_t child = current._index + 1; child < node._subtreeEnd; child = _bulkNodes[child]._subtreeEnd)
+		if (rayRectIntersect(origin, unitDirection, maxDistance, rectFromBounds(_bulkNodes[child]._lowerBound, _bulkNodes[child]._upperBound), entryDistance)) {
+			BulkSearchItem item = { entryDistance, child, true };
+
+			open.push(item);
+		}
+	}
+
+	recordQuery(0, nodesVisited, occupantsTested, 0);
+
+	return found;
+}
+
+QuadtreeStats StaticQuadtree::getStats() const {
+	QuadtreeStats stats = Quadtree::getStats();
+
+	// The bulk-loaded tree has its own root at depth 0. Nodes are in depth-first order,
+	// so the subtrees still open when a node is reached are exactly its ancestors
+	std::vector<size_t> openSubtreeEnds;
+
+	for (size_t i = 0; i < _bulkNodes.size(); i++) {
+		while (!openSubtreeEnds.empty() && openSubtreeEnds.back() <= i)
+			openSubtreeEnds.pop_back();
+
+		stats.addNodeAtDepth(openSubtreeEnds.size(), _bulkNodes[i]._numOccupants);
+
+		openSubtreeEnds.push_back(_bulkNodes[i]._subtreeEnd);
+	}
+
+	return stats;
 }
\ No newline at end of file
@@ -2,32 +2,95 @@
 
 #include <ltbl/quadtree/Quadtree.h>
 
+#include <cstdint>
+
 namespace ltbl {
 	class StaticQuadtree : public Quadtree
 	{
+	private:
+		// Node of the bulk-loaded tree. Nodes are stored in depth-first order, so the
+		// children of a node directly follow it and its subtree ends at _subtreeEnd
+		struct BulkNode {
+			// Bounds of all occupants in the subtree
+			sf::Vector2f _lowerBound, _upperBound;
+
+			size_t _firstOccupant;
+			size_t _numOccupants;
+
+			size_t _subtreeEnd;
+		};
+
+		struct BulkEntry {
+			// Morton code of the cell holding the occupant, with its level in the low bits
+			std::uint64_t _key;
+
+			// Position of the occupant in _buildInput
+			size_t _input;
+		};
+
+		std::vector<BulkNode> _bulkNodes;
+
+		// Occupants of the bulk-loaded tree in node order, with their AABBs alongside
+		std::vector<QuadtreeOccupant*> _bulkOccupants;
+		std::vector<sf::FloatRect> _bulkAABBs;
+
+		// Occupants of the last build that did not fit in the root, they are held in
+		// _outsideRoot next to any added ones
+		std::vector<QuadtreeOccupant*> _bulkOutsideRoot;
+
+		// Entry of the best-first searches of the bulk-loaded tree, a node or an occupant index
+		struct BulkSearchItem {
+			float _distance;
+
+			size_t _index;
+			bool _isNode;
+		};
+
+		// Scratch buffers of build
+		std::vector<QuadtreeOccupant*> _buildInput;
+		std::vector<BulkEntry> _buildEntries;
+		std::vector<BulkEntry> _buildSortBuffer;
+
+		void buildFromInput();
+		void sortBuildEntries(int keyBits);
+		void clearBulk();
+		size_t buildNode(size_t begin, size_t end, int level, int maxLevel);
+
 	public:
 		StaticQuadtree() {}
 		StaticQuadtree(const sf::FloatRect &rootRegion) {
-			_pRootNode.reset(new QuadtreeNode(rootRegion, 0, nullptr, this));
-		}
-
-		StaticQuadtree(const StaticQuadtree &other) {
-			*this = other;
-		}
-
-		void operator=(const StaticQuadtree &other) {
-			Quadtree::operator=(other);
+			_pRootNode.reset(_nodePool.create(rootRegion, 0, nullptr, this));
 		}
 
 		void create(const sf::FloatRect &rootRegion) {
-			_pRootNode.reset(new QuadtreeNode(rootRegion, 0, nullptr, this));
+			_pRootNode.reset(_nodePool.create(rootRegion, 0, nullptr, this));
 		}
 
 		// Inherited from Quadtree
 		void add(QuadtreeOccupant* oc);
 
+		// Replaces the bulk-loaded part of the tree with the occupants in [first, last),
+		// given as pointers or smart pointers. If the tree was not created, the root region
+		// is fitted to the occupants. Bulk-loaded occupants are fixed: quadtreeUpdate,
+		// quadtreeMarkDirty and quadtreeRemove do not apply to them, call build again
+		// after changing them
+		template<class Iterator>
+		void build(Iterator first, Iterator last) {
+			_buildInput.clear();
+
+			for (; first != last; first++)
+				_buildInput.push_back(&**first);
+
+			buildFromInput();
+		}
+
 		void clear() {
+			clearDirty();
+
 			_pRootNode.reset();
+
+			clearBulk();
+			_outsideRoot.clear();
 		}
 
 		const sf::FloatRect &getRootRegion() const {
@@ -37,5 +100,21 @@ namespace ltbl {
 		bool created() const {
 			return _pRootNode != nullptr;
 		}
+
+		size_t getNumBulkNodes() const {
+			return _bulkNodes.size();
+		}
+
+		// Inherited from Quadtree, also search the bulk-loaded tree
+		void queryRegion(std::vector<QuadtreeOccupant*> &result, const sf::FloatRect &region) const;
+		void queryPoint(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p) const;
+		void queryShape(std::vector<QuadtreeOccupant*> &result, const ShapeAxes &axes) const;
+		void queryNearest(std::vector<QuadtreeOccupant*> &result, const sf::Vector2f &p, size_t k) const;
+		bool raycast(const sf::Vector2f &origin, const sf::Vector2f &direction, float maxDistance, QuadtreeOccupant* &hit, float &distance) const;
+
+		using Quadtree::queryShape;
+
+		// Inherited from Quadtree, the bulk-loaded nodes are added to the depth histogram
+		QuadtreeStats getStats() const;
 	};
 }
\ No newline at end of file
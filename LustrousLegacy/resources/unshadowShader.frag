@@ -1,9 +1,10 @@
 uniform sampler2D penumbraTexture;
 
-uniform float lightBrightness;
-uniform float darkBrightness;
-
 void main() {
+    // Brightnesses of the penumbra edges come per vertex, so all penumbras can be drawn at once
+    float lightBrightness = gl_Color.r;
+    float darkBrightness = gl_Color.g;
+
     float penumbra = texture2D(penumbraTexture, gl_TexCoord[0].xy).x;
 	
 	float shadow = (lightBrightness - darkBrightness) * penumbra + darkBrightness;
@@ -8,6 +8,13 @@ Actor::Actor(const sf::Texture& imagePath) :
 	Pawn(imagePath) {
 }
 
+/*********************************************************************
+\brief Actor without a texture, see Pawn(unsigned int).
+*********************************************************************/
+Actor::Actor(unsigned int sprite_size) :
+	Pawn(sprite_size) {
+}
+
 /*********************************************************************
 \brief temp
 *********************************************************************/
@@ -101,6 +108,22 @@ sf::Vector2f Actor::getPastPosition() {
 	return pastPosition;
 }
 
+/*********************************************************************
+\brief Remembers where the actor stands before this frame's movement.
+	   Unlike the past position it is taken whether or not the actor
+	   moves, so collision sweeps never start from an earlier frame.
+*********************************************************************/
+void Actor::startFrame() {
+	frameStart = getPosition();
+}
+
+/*********************************************************************
+\brief Returns the position recorded by the last startFrame.
+*********************************************************************/
+sf::Vector2f Actor::getFrameStart() {
+	return frameStart;
+}
+
 /*********************************************************************
 \brief temp
 *********************************************************************/
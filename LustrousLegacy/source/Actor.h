@@ -17,6 +17,7 @@ class Actor : public Pawn {
 public:
 
 	Actor(const sf::Texture& playerTexture);
+	Actor(unsigned int sprite_size);
 	virtual ~Actor();
 	virtual void move(float elapsedTime, int direction);
 	virtual void move(float elapsedTime, sf::Vector2f pos);
@@ -30,6 +31,8 @@ public:
 	bool allowMovement(float elapsedTime);
 	sf::FloatRect getCollisionBox();
 	sf::Vector2f getPastPosition();
+	void startFrame();
+	sf::Vector2f getFrameStart();
 	sf::Vector2f getCurrentTarget();
 	virtual void collided();
 	void disableMovement();
@@ -39,7 +42,7 @@ public:
 	virtual std::string getClass();
 	bool hasTarget();
 	void setCurrentTarget(sf::Vector2f pos);
-	void Actor::popTarget();
+	void popTarget();
 	
 private:
 	int pastDirection;
@@ -53,6 +56,7 @@ private:
 	bool stop = false;
 	std::string actorScene = "";
 	sf::Vector2f pastPosition;
+	sf::Vector2f frameStart;
 	std::vector<sf::Vector2f> targetPositions;
 
 };
@@ -0,0 +1,133 @@
+#include "ActorRegions.h"
+#include "Actor.h"
+#include <algorithm>
+#include <cmath>
+
+/*********************************************************************
+ActorRegions class constructor.
+\brief Splits the map into square regions of region_size pixels.
+	   Actors in regions within wake_distance of the camera are awake,
+	   every other actor sleeps and costs nothing per frame. Sleepers
+	   wake where they fell asleep.
+*********************************************************************/
+ActorRegions::ActorRegions(int region_size, float wake_distance) :
+	regionSize(std::max(1, region_size)),
+	wakeDistance(wake_distance) {
+}
+
+/*********************************************************************
+\brief Takes over the actors of a newly loaded map. Everyone starts
+	   asleep, the first update wakes the actors around the camera.
+*********************************************************************/
+void ActorRegions::build(std::vector<Actor*>& actors, sf::Vector2u map_size) {
+	clear();
+
+	size.x = std::max(1, static_cast<int>(std::ceil(static_cast<float>(map_size.x) / regionSize)));
+	size.y = std::max(1, static_cast<int>(std::ceil(static_cast<float>(map_size.y) / regionSize)));
+	regions.resize(size.x * size.y);
+
+	for (auto actor = actors.begin(); actor != actors.end(); actor++)
+		sleep(*actor);
+}
+
+/*********************************************************************
+\brief Forgets every actor.
+*********************************************************************/
+void ActorRegions::clear() {
+	sleeping = 0;
+	size = sf::Vector2i(0, 0);
+	active = sf::IntRect();
+	regions.clear();
+	awake.clear();
+}
+
+/*********************************************************************
+\brief Called once per game tick with the camera view. Awake actors
+	   outside the active regions fall asleep and the sleepers of
+	   regions that became active wake. Cost depends on the awake actors and the regions
+	   that changed, not on how many actors the map holds.
+*********************************************************************/
+void ActorRegions::update(const sf::View& view) {
+	if (regions.empty())
+		return;
+
+	sf::Vector2f half = view.getSize() / 2.f + sf::Vector2f(wakeDistance, wakeDistance);
+	sf::Vector2f top_left = view.getCenter() - half;
+	sf::Vector2f bottom_right = view.getCenter() + half;
+
+	int min_x = std::max(0, static_cast<int>(std::floor(top_left.x / regionSize)));
+	int min_y = std::max(0, static_cast<int>(std::floor(top_left.y / regionSize)));
+	int max_x = std::min(size.x - 1, static_cast<int>(std::floor(bottom_right.x / regionSize)));
+	int max_y = std::min(size.y - 1, static_cast<int>(std::floor(bottom_right.y / regionSize)));
+
+	sf::IntRect previous = active;
+	active = sf::IntRect(min_x, min_y, std::max(0, max_x - min_x + 1), std::max(0, max_y - min_y + 1));
+
+	// put actors that walked out of the active area, or were left behind
+	// by the camera, to sleep
+	for (unsigned int i = 0; i < awake.size();) {
+		unsigned int region = regionIndex(awake[i]->getPosition());
+		if (isActive(region % size.x, region / size.x)) {
+			i++;
+			continue;
+		}
+		sleep(awake[i]);
+		awake[i] = awake.back();
+		awake.pop_back();
+	}
+
+	if (active == previous)
+		return;
+
+	// wake the sleepers of regions that just became active
+	for (int y = min_y; y <= max_y; y++) {
+		for (int x = min_x; x <= max_x; x++) {
+			if (previous.contains(x, y))
+				continue;
+
+			std::vector<Actor*>& region = regions[y * size.x + x];
+			awake.insert(awake.end(), region.begin(), region.end());
+			sleeping -= region.size();
+			region.clear();
+		}
+	}
+}
+
+/*********************************************************************
+\brief Returns the actors that should be moved and collided this tick.
+*********************************************************************/
+std::vector<Actor*>& ActorRegions::getAwake() {
+	return awake;
+}
+
+/*********************************************************************
+\brief Returns how many actors are currently asleep.
+*********************************************************************/
+unsigned int ActorRegions::getSleeping() {
+	return sleeping;
+}
+
+/*********************************************************************
+\brief Returns the region holding a position, positions off the map
+	   belong to the nearest edge region.
+*********************************************************************/
+unsigned int ActorRegions::regionIndex(sf::Vector2f position) {
+	int x = std::min(size.x - 1, std::max(0, static_cast<int>(std::floor(position.x / regionSize))));
+	int y = std::min(size.y - 1, std::max(0, static_cast<int>(std::floor(position.y / regionSize))));
+	return y * size.x + x;
+}
+
+/*********************************************************************
+\brief Returns true if a region is inside the active area.
+*********************************************************************/
+bool ActorRegions::isActive(int region_x, int region_y) {
+	return active.contains(region_x, region_y);
+}
+
+/*********************************************************************
+\brief Files an actor under the region it stands in.
+*********************************************************************/
+void ActorRegions::sleep(Actor* actor) {
+	regions[regionIndex(actor->getPosition())].push_back(actor);
+	sleeping++;
+}
@@ -0,0 +1,34 @@
+#ifndef ACTORREGIONS_H_
+#define ACTORREGIONS_H_
+
+#include "Enums.h"
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+class Actor;
+
+class ActorRegions {
+public:
+
+	ActorRegions(int region_size = System::Tilesize * 16, float wake_distance = System::Tilesize * 8.f);
+	void build(std::vector<Actor*>& actors, sf::Vector2u map_size);
+	void clear();
+	void update(const sf::View& view);
+	std::vector<Actor*>& getAwake();
+	unsigned int getSleeping();
+
+private:
+
+	unsigned int regionIndex(sf::Vector2f position);
+	bool isActive(int region_x, int region_y);
+	void sleep(Actor* actor);
+
+	int regionSize;
+	float wakeDistance;
+	unsigned int sleeping = 0;
+	sf::Vector2i size;
+	sf::IntRect active;
+	std::vector<std::vector<Actor*>> regions;
+	std::vector<Actor*> awake;
+};
+#endif
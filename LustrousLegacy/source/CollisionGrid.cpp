@@ -0,0 +1,143 @@
+#include "CollisionGrid.h"
+#include "Actor.h"
+#include <algorithm>
+#include <cmath>
+
+/*********************************************************************
+CollisionGrid class constructor.
+\brief Uniform spatial hash over actor collision boxes. Cells are
+	   cell_size pixels square, which defaults to one map tile.
+*********************************************************************/
+CollisionGrid::CollisionGrid(int cell_size) :
+	cellSize(cell_size) {
+}
+
+/*********************************************************************
+\brief Packs a cell coordinate pair into a single sortable key.
+*********************************************************************/
+long long CollisionGrid::cellKey(int cell_x, int cell_y) {
+	// multiplied rather than shifted, shifting a negative row is undefined
+	return static_cast<long long>(cell_y) * 0x100000000LL + static_cast<unsigned int>(cell_x);
+}
+
+/*********************************************************************
+\brief Returns the cell coordinate containing a world position.
+*********************************************************************/
+int CollisionGrid::cellCoord(float pos) {
+	return static_cast<int>(std::floor(pos / cellSize));
+}
+
+/*********************************************************************
+\brief Snapshots the collision box of every actor and files it under
+	   each cell the box overlaps. Buffers are kept between frames so
+	   a steady actor count does not allocate.
+*********************************************************************/
+void CollisionGrid::build(std::vector<Actor*>& actors) {
+	entries.clear();
+	cellRefs.clear();
+
+	for (auto actor = actors.begin(); actor != actors.end(); actor++) {
+		Entry entry;
+		entry.actor = *actor;
+		entry.box = (*actor)->getCollisionBox();
+		entry.position = (*actor)->getPosition();
+		entries.push_back(entry);
+
+		unsigned int index = entries.size() - 1;
+		int min_x = cellCoord(entry.box.left);
+		int max_x = cellCoord(entry.box.left + entry.box.width);
+		int min_y = cellCoord(entry.box.top);
+		int max_y = cellCoord(entry.box.top + entry.box.height);
+
+		for (int y = min_y; y <= max_y; y++) {
+			for (int x = min_x; x <= max_x; x++) {
+				CellRef ref;
+				ref.cell = cellKey(x, y);
+				ref.entry = index;
+				cellRefs.push_back(ref);
+			}
+		}
+	}
+
+	std::sort(cellRefs.begin(), cellRefs.end(), [](const CellRef& a, const CellRef& b) {
+		return a.cell < b.cell || (a.cell == b.cell && a.entry < b.entry);
+	});
+}
+
+/*********************************************************************
+\brief Returns every unique pair of overlapping actors.
+	   Pairs sharing several cells are only reported from the cell
+	   holding the top left corner of their overlap.
+*********************************************************************/
+const std::vector<std::pair<Actor*, Actor*>>& CollisionGrid::findPairs() {
+	pairs.clear();
+	pairsTested = 0;
+
+	size_t run_start = 0;
+	while (run_start < cellRefs.size()) {
+		size_t run_end = run_start + 1;
+		while (run_end < cellRefs.size() && cellRefs[run_end].cell == cellRefs[run_start].cell)
+			run_end++;
+
+		for (size_t i = run_start; i < run_end; i++) {
+			const Entry& first = entries[cellRefs[i].entry];
+			for (size_t j = i + 1; j < run_end; j++) {
+				const Entry& second = entries[cellRefs[j].entry];
+				sf::FloatRect overlap;
+				pairsTested++;
+
+				if (!first.box.intersects(second.box, overlap) || first.position == second.position)
+					continue;
+				if (cellKey(cellCoord(overlap.left), cellCoord(overlap.top)) != cellRefs[run_start].cell)
+					continue;
+
+				pairs.push_back(std::make_pair(first.actor, second.actor));
+			}
+		}
+		run_start = run_end;
+	}
+	return pairs;
+}
+
+/*********************************************************************
+\brief Returns how many box tests the last findPairs performed.
+*********************************************************************/
+unsigned int CollisionGrid::getPairsTested() {
+	return pairsTested;
+}
+
+/*********************************************************************
+\brief Fills results with the actors whose collision box, as of the
+	   last build, overlaps area. Only the cells under area are
+	   visited and actors come back in the order given to build.
+*********************************************************************/
+void CollisionGrid::query(const sf::FloatRect& area, std::vector<Actor*>& results) {
+	results.clear();
+	found.clear();
+
+	int min_x = cellCoord(area.left);
+	int max_x = cellCoord(area.left + area.width);
+	int min_y = cellCoord(area.top);
+	int max_y = cellCoord(area.top + area.height);
+
+	for (int y = min_y; y <= max_y; y++) {
+		for (int x = min_x; x <= max_x; x++) {
+			long long key = cellKey(x, y);
+			auto ref = std::lower_bound(cellRefs.begin(), cellRefs.end(), key, [](const CellRef& a, long long cell) {
+				return a.cell < cell;
+			});
+
+			for (; ref != cellRefs.end() && ref->cell == key; ref++) {
+				if (entries[ref->entry].box.intersects(area))
+					found.push_back(ref->entry);
+			}
+		}
+	}
+
+	// an actor spanning several cells is listed once per cell
+	std::sort(found.begin(), found.end());
+	found.erase(std::unique(found.begin(), found.end()), found.end());
+
+	for (auto entry = found.begin(); entry != found.end(); entry++)
+		results.push_back(entries[*entry].actor);
+}
@@ -0,0 +1,43 @@
+#ifndef COLLISIONGRID_H_
+#define COLLISIONGRID_H_
+
+#include "Enums.h"
+#include <SFML/Graphics.hpp>
+#include <utility>
+#include <vector>
+
+class Actor;
+
+class CollisionGrid {
+public:
+
+	CollisionGrid(int cell_size = System::Tilesize);
+	void build(std::vector<Actor*>& actors);
+	const std::vector<std::pair<Actor*, Actor*>>& findPairs();
+	unsigned int getPairsTested();
+	void query(const sf::FloatRect& area, std::vector<Actor*>& results);
+
+private:
+
+	struct Entry {
+		Actor* actor;
+		sf::FloatRect box;
+		sf::Vector2f position;
+	};
+
+	struct CellRef {
+		long long cell;
+		unsigned int entry;
+	};
+
+	long long cellKey(int cell_x, int cell_y);
+	int cellCoord(float pos);
+
+	int cellSize;
+	unsigned int pairsTested = 0;
+	std::vector<Entry> entries;
+	std::vector<CellRef> cellRefs;
+	std::vector<std::pair<Actor*, Actor*>> pairs;
+	std::vector<unsigned int> found;
+};
+#endif
@@ -0,0 +1,275 @@
+#include "CollisionMap.h"
+#include "tmx/MapLoader.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/*********************************************************************
+CollisionMap class constructor.
+\brief Rasterizes a collision object layer into a grid matching the
+	   map tiles, split into subdivisions x subdivisions cells per tile.
+*********************************************************************/
+CollisionMap::CollisionMap(unsigned int subdivisions) :
+	subdivisions(std::max(1u, subdivisions)) {
+}
+
+/*********************************************************************
+\brief Rebuilds the grid from a set of collision objects, normally
+	   the Collision layer of a MapIndex.
+	   Cells fully inside a convex object are marked solid, cells the
+	   object only touches are marked partial. Every cell remembers the
+	   objects touching it for exact tests and sweeps.
+*********************************************************************/
+void CollisionMap::build(tmx::MapLoader& map, const std::vector<tmx::MapObject*>& objects) {
+	clear();
+
+	sf::Vector2u tile_size = map.GetTileSize();
+	sf::Vector2u map_size = map.GetMapSize();
+	if (tile_size.x == 0 || tile_size.y == 0)
+		return;
+
+	size = sf::Vector2u(map_size.x / tile_size.x * subdivisions, map_size.y / tile_size.y * subdivisions);
+	cellSize = sf::Vector2f(static_cast<float>(tile_size.x) / subdivisions, static_cast<float>(tile_size.y) / subdivisions);
+	solid.assign(size.x * size.y, false);
+	partial.assign(size.x * size.y, false);
+
+	std::vector<std::pair<unsigned int, unsigned int>> candidates;
+
+	for (auto object = objects.begin(); object != objects.end(); ++object) {
+		if ((*object)->GetShapeType() == tmx::Polyline || (*object)->PolyPoints().size() < 3)
+			continue;
+
+		unsigned int polygon = polygons.add(**object);
+		sf::FloatRect aabb = polygons.getAABB(polygon);
+		int min_x = std::max(0, static_cast<int>(std::floor(aabb.left / cellSize.x)));
+		int min_y = std::max(0, static_cast<int>(std::floor(aabb.top / cellSize.y)));
+		int max_x = std::min(static_cast<int>(size.x) - 1, static_cast<int>(std::floor((aabb.left + aabb.width) / cellSize.x)));
+		int max_y = std::min(static_cast<int>(size.y) - 1, static_cast<int>(std::floor((aabb.top + aabb.height) / cellSize.y)));
+
+		for (int y = min_y; y <= max_y; y++) {
+			for (int x = min_x; x <= max_x; x++) {
+				unsigned int index = y * size.x + x;
+				sf::FloatRect cell(x * cellSize.x, y * cellSize.y, cellSize.x, cellSize.y);
+
+				if ((*object)->Convex() && coversCell(polygon, cell))
+					solid[index] = true;
+				candidates.push_back(std::make_pair(index, polygon));
+			}
+		}
+	}
+
+	// pack the objects touching each cell contiguously, solid cells keep theirs
+	// too so sweeps can find the walls to slide along
+	cellStart.assign(size.x * size.y + 1, 0);
+	for (auto candidate = candidates.begin(); candidate != candidates.end(); candidate++) {
+		if (!solid[candidate->first])
+			partial[candidate->first] = true;
+		cellStart[candidate->first + 1]++;
+	}
+	for (unsigned int i = 1; i < cellStart.size(); i++)
+		cellStart[i] += cellStart[i - 1];
+
+	cellPolygons.resize(cellStart.back());
+	std::vector<unsigned int> fill(cellStart.begin(), cellStart.end() - 1);
+	for (auto candidate = candidates.begin(); candidate != candidates.end(); candidate++)
+		cellPolygons[fill[candidate->first]++] = candidate->second;
+}
+
+/*********************************************************************
+\brief Empties the grid, nothing is blocked afterwards.
+*********************************************************************/
+void CollisionMap::clear() {
+	size = sf::Vector2u(0, 0);
+	solid.clear();
+	partial.clear();
+	cellStart.clear();
+	cellPolygons.clear();
+	polygons.clear();
+}
+
+/*********************************************************************
+\brief Returns true if the point is inside a collision object.
+	   Solid and open cells are answered by a single lookup, only
+	   partial cells fall back to the exact polygon test.
+*********************************************************************/
+bool CollisionMap::blocked(sf::Vector2f point) {
+	unsigned int index;
+	if (!cellIndex(point, index))
+		return false;
+	if (solid[index])
+		return true;
+	if (!partial[index])
+		return false;
+
+	for (unsigned int i = cellStart[index]; i < cellStart[index + 1]; i++) {
+		if (polygons.contains(cellPolygons[i], point))
+			return true;
+	}
+	return false;
+}
+
+/*********************************************************************
+\brief Moves a point from start towards end, stopping at the first
+	   collision edge crossed and sliding the remaining movement along
+	   that edge. Returns the resolved position.
+*********************************************************************/
+sf::Vector2f CollisionMap::sweep(sf::Vector2f start, sf::Vector2f end) {
+	// distance kept between a resolved position and the wall it touches
+	const float skin = 0.05f;
+
+	if (start == end)
+		return end;
+
+	// positions that are not finite can not be swept, keep the usable end
+	if (!std::isfinite(end.x) || !std::isfinite(end.y))
+		return start;
+	if (!std::isfinite(start.x) || !std::isfinite(start.y))
+		return end;
+
+	// already inside a wall, only allow moves that leave it
+	if (blocked(start))
+		return blocked(end) ? start : end;
+
+	float time;
+	sf::Vector2f normal;
+	if (!firstHit(start, end, time, normal))
+		return blocked(end) ? start : end;
+
+	sf::Vector2f delta = end - start;
+	sf::Vector2f contact = start + delta * time + normal * skin;
+
+	// drop the part of the remaining movement that points into the wall
+	sf::Vector2f rest = delta * (1.f - time);
+	sf::Vector2f slide = rest - normal * (rest.x * normal.x + rest.y * normal.y);
+	sf::Vector2f target = contact + slide;
+
+	// sliding into a second wall (a corner) stops at that wall
+	if (firstHit(contact, target, time, normal))
+		target = contact + slide * time + normal * skin;
+
+	if (blocked(target))
+		return blocked(contact) ? start : contact;
+	return target;
+}
+
+/*********************************************************************
+\brief Returns true if the cell is entirely covered by an object.
+*********************************************************************/
+bool CollisionMap::isSolid(unsigned int cell_x, unsigned int cell_y) {
+	return cell_x < size.x && cell_y < size.y && solid[cell_y * size.x + cell_x];
+}
+
+/*********************************************************************
+\brief Returns true if the cell is only partly covered by objects.
+*********************************************************************/
+bool CollisionMap::isPartial(unsigned int cell_x, unsigned int cell_y) {
+	return cell_x < size.x && cell_y < size.y && partial[cell_y * size.x + cell_x];
+}
+
+/*********************************************************************
+\brief Returns the grid dimensions in cells.
+*********************************************************************/
+sf::Vector2u CollisionMap::getSize() {
+	return size;
+}
+
+/*********************************************************************
+\brief Returns the dimensions of a single cell in pixels.
+*********************************************************************/
+sf::Vector2f CollisionMap::getCellSize() {
+	return cellSize;
+}
+
+/*********************************************************************
+\brief Finds the cell holding a world position.
+	   Returns false if the position lies outside of the map.
+*********************************************************************/
+bool CollisionMap::cellIndex(sf::Vector2f point, unsigned int& index) {
+	// compared as floats first, NaN and infinity fail here instead of
+	// being cast to an out of range integer
+	float x = point.x / cellSize.x;
+	float y = point.y / cellSize.y;
+	if (!(x >= 0.f && x < size.x && y >= 0.f && y < size.y))
+		return false;
+
+	index = static_cast<unsigned int>(y) * size.x + static_cast<unsigned int>(x);
+	return true;
+}
+
+/*********************************************************************
+\brief Returns true if all four corners of the cell lie inside a
+	   polygon. Only meaningful for convex shapes, the caller checks.
+*********************************************************************/
+bool CollisionMap::coversCell(unsigned int polygon, const sf::FloatRect& cell) {
+	// Contains() excludes the right and bottom edges of a shape, so pull the far
+	// corners just inside the cell or tile aligned rectangles never count as solid
+	const float inset = 0.01f;
+	float right = cell.left + cell.width - inset;
+	float bottom = cell.top + cell.height - inset;
+
+	sf::Vector2f corners[4] = {
+		sf::Vector2f(cell.left, cell.top),
+		sf::Vector2f(right, cell.top),
+		sf::Vector2f(right, bottom),
+		sf::Vector2f(cell.left, bottom)
+	};
+	bool inside[4];
+	polygons.containsBatch(polygon, corners, 4, inside);
+
+	return inside[0] && inside[1] && inside[2] && inside[3];
+}
+
+/*********************************************************************
+\brief Finds the earliest collision edge crossed by the segment from
+	   start to end. time is the fraction of the segment travelled
+	   and normal faces back against the movement.
+*********************************************************************/
+bool CollisionMap::firstHit(sf::Vector2f start, sf::Vector2f end, float& time, sf::Vector2f& normal) {
+	sf::Vector2f delta = end - start;
+	bool hit = false;
+	time = 1.f;
+
+	gatherObjects(sf::FloatRect(std::min(start.x, end.x), std::min(start.y, end.y), std::abs(delta.x), std::abs(delta.y)));
+
+	sf::Vector2f edge;
+	for (auto polygon = nearby.begin(); polygon != nearby.end(); polygon++) {
+		if (polygons.firstEdgeHit(*polygon, start, end, time, edge))
+			hit = true;
+	}
+	if (!hit)
+		return false;
+
+	// same construction as MapObject::CollisionNormal, but taken from
+	// the earliest edge hit and always facing the incoming movement
+	sf::Vector2f n(edge.y, -edge.x);
+	if (n.x * delta.x + n.y * delta.y > 0.f)
+		n = -n;
+
+	normal = n / std::sqrt(n.x * n.x + n.y * n.y);
+	return true;
+}
+
+/*********************************************************************
+\brief Collects the distinct polygons listed under the cells an area
+	   overlaps into the nearby buffer.
+*********************************************************************/
+void CollisionMap::gatherObjects(const sf::FloatRect& area) {
+	nearby.clear();
+	if (size.x == 0 || size.y == 0)
+		return;
+
+	int min_x = std::max(0, static_cast<int>(std::floor(area.left / cellSize.x)));
+	int min_y = std::max(0, static_cast<int>(std::floor(area.top / cellSize.y)));
+	int max_x = std::min(static_cast<int>(size.x) - 1, static_cast<int>(std::floor((area.left + area.width) / cellSize.x)));
+	int max_y = std::min(static_cast<int>(size.y) - 1, static_cast<int>(std::floor((area.top + area.height) / cellSize.y)));
+
+	for (int y = min_y; y <= max_y; y++) {
+		for (int x = min_x; x <= max_x; x++) {
+			unsigned int index = y * size.x + x;
+			for (unsigned int i = cellStart[index]; i < cellStart[index + 1]; i++) {
+				if (std::find(nearby.begin(), nearby.end(), cellPolygons[i]) == nearby.end())
+					nearby.push_back(cellPolygons[i]);
+			}
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef COLLISIONMAP_H_
+#define COLLISIONMAP_H_
+
+#include "CollisionPolygons.h"
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace tmx {
+
+	class MapLoader;
+	class MapObject;
+}
+
+class CollisionMap {
+public:
+
+	CollisionMap(unsigned int subdivisions = 1);
+	void build(tmx::MapLoader& map, const std::vector<tmx::MapObject*>& objects);
+	void clear();
+	bool blocked(sf::Vector2f point);
+	sf::Vector2f sweep(sf::Vector2f start, sf::Vector2f end);
+	bool isSolid(unsigned int cell_x, unsigned int cell_y);
+	bool isPartial(unsigned int cell_x, unsigned int cell_y);
+	sf::Vector2u getSize();
+	sf::Vector2f getCellSize();
+
+private:
+
+	bool cellIndex(sf::Vector2f point, unsigned int& index);
+	bool coversCell(unsigned int polygon, const sf::FloatRect& cell);
+	bool firstHit(sf::Vector2f start, sf::Vector2f end, float& time, sf::Vector2f& normal);
+	void gatherObjects(const sf::FloatRect& area);
+
+	unsigned int subdivisions;
+	sf::Vector2u size;
+	sf::Vector2f cellSize;
+	std::vector<bool> solid;
+	std::vector<bool> partial;
+	std::vector<unsigned int> cellStart;
+	std::vector<unsigned int> cellPolygons;
+	std::vector<unsigned int> nearby;
+	CollisionPolygons polygons;
+};
+#endif
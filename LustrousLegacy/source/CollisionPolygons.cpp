@@ -0,0 +1,195 @@
+#include "CollisionPolygons.h"
+#include "tmx/MapObject.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLLISION_SSE2
+#include <emmintrin.h>
+#endif
+
+/*********************************************************************
+\brief Copies the outline of a map object into the edge arrays and
+	   returns its polygon index.
+*********************************************************************/
+unsigned int CollisionPolygons::add(const tmx::MapObject& object) {
+	const std::vector<sf::Vector2f>& points = object.PolyPoints();
+
+	Polygon polygon;
+	polygon.object = &object;
+	polygon.position = object.GetPosition();
+	polygon.aabb = object.GetAABB();
+	polygon.first = ix.size();
+	polygon.count = points.size();
+	polygon.closed = object.GetShapeType() != tmx::Polyline;
+
+	for (unsigned int i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+		ix.push_back(points[i].x);
+		iy.push_back(points[i].y);
+		jx.push_back(points[j].x);
+		jy.push_back(points[j].y);
+	}
+
+	// padding edges are horizontal at y = 0 so they never straddle a point
+	while (ix.size() % 4 != 0) {
+		ix.push_back(0.f);
+		iy.push_back(0.f);
+		jx.push_back(0.f);
+		jy.push_back(0.f);
+	}
+
+	polygons.push_back(polygon);
+	return polygons.size() - 1;
+}
+
+/*********************************************************************
+\brief Removes every polygon.
+*********************************************************************/
+void CollisionPolygons::clear() {
+	polygons.clear();
+	ix.clear();
+	iy.clear();
+	jx.clear();
+	jy.clear();
+}
+
+/*********************************************************************
+\brief Returns the number of polygons stored.
+*********************************************************************/
+unsigned int CollisionPolygons::size() {
+	return polygons.size();
+}
+
+/*********************************************************************
+\brief Returns the map object a polygon was copied from.
+*********************************************************************/
+const tmx::MapObject* CollisionPolygons::getObject(unsigned int polygon) {
+	return polygons[polygon].object;
+}
+
+/*********************************************************************
+\brief Returns the world space bounding box of a polygon.
+*********************************************************************/
+sf::FloatRect CollisionPolygons::getAABB(unsigned int polygon) {
+	return polygons[polygon].aabb;
+}
+
+/*********************************************************************
+\brief Point in polygon test giving the same answer as
+	   MapObject::Contains. The crossing test runs on four edges at
+	   a time where SSE2 is available.
+*********************************************************************/
+bool CollisionPolygons::contains(unsigned int polygon, sf::Vector2f point) {
+	const Polygon& poly = polygons[polygon];
+	if (!poly.closed || poly.count < 3)
+		return false;
+
+	float px = point.x - poly.position.x;
+	float py = point.y - poly.position.y;
+
+#ifdef COLLISION_SSE2
+	__m128 vx = _mm_set1_ps(px);
+	__m128 vy = _mm_set1_ps(py);
+	int crossings = 0;
+
+	for (unsigned int e = poly.first; e < poly.first + poly.count; e += 4) {
+		__m128 xi = _mm_loadu_ps(&ix[e]);
+		__m128 yi = _mm_loadu_ps(&iy[e]);
+		__m128 xj = _mm_loadu_ps(&jx[e]);
+		__m128 yj = _mm_loadu_ps(&jy[e]);
+
+		__m128 straddles = _mm_xor_ps(_mm_cmpgt_ps(yi, vy), _mm_cmpgt_ps(yj, vy));
+		__m128 cross_x = _mm_add_ps(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(xj, xi), _mm_sub_ps(vy, yi)), _mm_sub_ps(yj, yi)), xi);
+		int mask = _mm_movemask_ps(_mm_and_ps(straddles, _mm_cmplt_ps(vx, cross_x)));
+
+		crossings += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+	}
+	return (crossings & 1) != 0;
+#else
+	bool result = false;
+	for (unsigned int e = poly.first; e < poly.first + poly.count; e++) {
+		if (((iy[e] > py) != (jy[e] > py)) &&
+			(px < (jx[e] - ix[e]) * (py - iy[e]) / (jy[e] - iy[e]) + ix[e]))
+			result = !result;
+	}
+	return result;
+#endif
+}
+
+/*********************************************************************
+\brief Tests many points against one polygon, writing one result per
+	   point. Four points are tested per pass where SSE2 is available.
+*********************************************************************/
+void CollisionPolygons::containsBatch(unsigned int polygon, const sf::Vector2f* points, unsigned int count, bool* results) {
+	const Polygon& poly = polygons[polygon];
+	if (!poly.closed || poly.count < 3) {
+		for (unsigned int p = 0; p < count; p++)
+			results[p] = false;
+		return;
+	}
+
+	unsigned int p = 0;
+
+#ifdef COLLISION_SSE2
+	for (; p + 4 <= count; p += 4) {
+		__m128 vx = _mm_setr_ps(points[p].x - poly.position.x, points[p + 1].x - poly.position.x,
+			points[p + 2].x - poly.position.x, points[p + 3].x - poly.position.x);
+		__m128 vy = _mm_setr_ps(points[p].y - poly.position.y, points[p + 1].y - poly.position.y,
+			points[p + 2].y - poly.position.y, points[p + 3].y - poly.position.y);
+		__m128 inside = _mm_setzero_ps();
+
+		for (unsigned int e = poly.first; e < poly.first + poly.count; e++) {
+			__m128 xi = _mm_set1_ps(ix[e]);
+			__m128 yi = _mm_set1_ps(iy[e]);
+			__m128 xj = _mm_set1_ps(jx[e]);
+			__m128 yj = _mm_set1_ps(jy[e]);
+
+			__m128 straddles = _mm_xor_ps(_mm_cmpgt_ps(yi, vy), _mm_cmpgt_ps(yj, vy));
+			__m128 cross_x = _mm_add_ps(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(xj, xi), _mm_sub_ps(vy, yi)), _mm_sub_ps(yj, yi)), xi);
+			inside = _mm_xor_ps(inside, _mm_and_ps(straddles, _mm_cmplt_ps(vx, cross_x)));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		results[p] = (mask & 1) != 0;
+		results[p + 1] = (mask & 2) != 0;
+		results[p + 2] = (mask & 4) != 0;
+		results[p + 3] = (mask & 8) != 0;
+	}
+#endif
+
+	for (; p < count; p++)
+		results[p] = contains(polygon, points[p]);
+}
+
+/*********************************************************************
+\brief Finds the earliest edge of a polygon crossed by the segment
+	   from start to end. Only hits before time are accepted; on a hit
+	   time is updated and edge receives the edge direction.
+*********************************************************************/
+bool CollisionPolygons::firstEdgeHit(unsigned int polygon, sf::Vector2f start, sf::Vector2f end, float& time, sf::Vector2f& edge) {
+	const Polygon& poly = polygons[polygon];
+	sf::Vector2f delta = end - start;
+	sf::Vector2f local = start - poly.position;
+	bool hit = false;
+
+	for (unsigned int e = poly.first; e < poly.first + poly.count; e++) {
+		// polylines have no closing edge
+		if (!poly.closed && e == poly.first)
+			continue;
+
+		sf::Vector2f direction(ix[e] - jx[e], iy[e] - jy[e]);
+		float denom = delta.x * direction.y - delta.y * direction.x;
+		if (denom == 0.f)
+			continue;
+
+		sf::Vector2f to_edge(jx[e] - local.x, jy[e] - local.y);
+		float t = (to_edge.x * direction.y - to_edge.y * direction.x) / denom;
+		float u = (to_edge.x * delta.y - to_edge.y * delta.x) / denom;
+
+		if (t < 0.f || t > time || u < 0.f || u > 1.f)
+			continue;
+
+		time = t;
+		edge = direction;
+		hit = true;
+	}
+	return hit;
+}
@@ -0,0 +1,42 @@
+#ifndef COLLISIONPOLYGONS_H_
+#define COLLISIONPOLYGONS_H_
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace tmx {
+
+	class MapObject;
+}
+
+class CollisionPolygons {
+public:
+
+	unsigned int add(const tmx::MapObject& object);
+	void clear();
+	unsigned int size();
+	const tmx::MapObject* getObject(unsigned int polygon);
+	sf::FloatRect getAABB(unsigned int polygon);
+	bool contains(unsigned int polygon, sf::Vector2f point);
+	void containsBatch(unsigned int polygon, const sf::Vector2f* points, unsigned int count, bool* results);
+	bool firstEdgeHit(unsigned int polygon, sf::Vector2f start, sf::Vector2f end, float& time, sf::Vector2f& edge);
+
+private:
+
+	struct Polygon {
+		const tmx::MapObject* object;
+		sf::Vector2f position;
+		sf::FloatRect aabb;
+		unsigned int first;
+		unsigned int count;
+		bool closed;
+	};
+
+	std::vector<Polygon> polygons;
+
+	// edge k of a polygon joins point i = k to point j = k - 1, named as in
+	// MapObject::Contains. Stored as structure of arrays in object local space,
+	// each polygon padded to a multiple of four edges
+	std::vector<float> ix, iy, jx, jy;
+};
+#endif
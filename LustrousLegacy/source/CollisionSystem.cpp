@@ -0,0 +1,38 @@
+#include "CollisionSystem.h"
+#include "Actor.h"
+#include "CollisionGrid.h"
+#include "CollisionMap.h"
+
+/*********************************************************************
+/brief Performs the collision between actors.
+	   Only actors sharing a grid cell are tested and each colliding
+	   pair is resolved once.
+*********************************************************************/
+void actorCollision(std::vector<Actor*>& actors, CollisionGrid& grid)
+{
+	grid.build(actors);
+	const std::vector<std::pair<Actor*, Actor*>>& pairs = grid.findPairs();
+
+	for (auto pair = pairs.begin(); pair != pairs.end(); pair++) {
+		pair->first->collided();
+		pair->second->collided();
+	}
+}
+
+/*********************************************************************
+\brief Performs the collision handling for all actors.
+*********************************************************************/
+void sysCollision(std::vector<Actor*>& actors, CollisionMap& collision, CollisionGrid& grid)
+{
+	// perform basic actor collision checking
+	actorCollision(actors, grid);
+
+	// sweep each actor's movement this frame against the collision layer,
+	// actors stop at walls and slide along them instead of snapping back.
+	// Actors must have had startFrame called before they moved
+	for (auto actor = actors.begin(); actor != actors.end(); actor++) {
+		sf::Vector2f resolved = collision.sweep((*actor)->getFrameStart(), (*actor)->getPosition());
+		if (resolved != (*actor)->getPosition())
+			(*actor)->setPosition(resolved);
+	}
+}
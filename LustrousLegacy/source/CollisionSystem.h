@@ -0,0 +1,13 @@
+#ifndef COLLISIONSYSTEM_H_
+#define COLLISIONSYSTEM_H_
+
+#include <vector>
+
+class Actor;
+class CollisionGrid;
+class CollisionMap;
+
+void sysCollision(std::vector<Actor*>& actors, CollisionMap& collision, CollisionGrid& grid);
+void actorCollision(std::vector<Actor*>& actors, CollisionGrid& grid);
+
+#endif
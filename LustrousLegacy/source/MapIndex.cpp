@@ -0,0 +1,66 @@
+#include "MapIndex.h"
+#include "tmx/MapLoader.h"
+
+/*********************************************************************
+MapIndex class constructor.
+\brief Keeps the objects of every object layer of a map. Layers are
+	   looked up by name once and then addressed by a small integer.
+	   Spatial queries go through the structures built from a layer,
+	   such as CollisionMap, so no tree is kept per layer.
+*********************************************************************/
+MapIndex::MapIndex() {
+}
+
+/*********************************************************************
+MapIndex class destructor.
+*********************************************************************/
+MapIndex::~MapIndex() {
+}
+
+/*********************************************************************
+\brief Rebuilds the layer table from the object layers of the loaded
+	   map. Handles from a previous map are invalid.
+*********************************************************************/
+void MapIndex::build(tmx::MapLoader& map) {
+	clear();
+
+	for (auto layer = map.GetLayers().begin(); layer != map.GetLayers().end(); ++layer) {
+		if (layer->type != tmx::ObjectGroup)
+			continue;
+
+		LayerEntry entry;
+		entry.name = layer->name;
+
+		for (auto object = layer->objects.begin(); object != layer->objects.end(); ++object)
+			entry.objects.push_back(&*object);
+		layers.push_back(std::move(entry));
+	}
+}
+
+/*********************************************************************
+\brief Drops every layer.
+*********************************************************************/
+void MapIndex::clear() {
+	layers.clear();
+}
+
+/*********************************************************************
+\brief Returns the handle of the named object layer, or NoLayer.
+	   Meant to be called once after loading, not every frame.
+*********************************************************************/
+int MapIndex::getLayer(const std::string& layer_name) {
+	for (unsigned int i = 0; i < layers.size(); i++) {
+		if (layers[i].name == layer_name)
+			return i;
+	}
+	return NoLayer;
+}
+
+/*********************************************************************
+\brief Returns every object of a layer.
+*********************************************************************/
+const std::vector<tmx::MapObject*>& MapIndex::getObjects(int layer) {
+	if (layer < 0 || layer >= static_cast<int>(layers.size()))
+		return noObjects;
+	return layers[layer].objects;
+}
@@ -0,0 +1,35 @@
+#ifndef MAPINDEX_H_
+#define MAPINDEX_H_
+
+#include <string>
+#include <vector>
+
+namespace tmx {
+
+	class MapLoader;
+	class MapObject;
+}
+
+class MapIndex {
+public:
+
+	static const int NoLayer = -1;
+
+	MapIndex();
+	~MapIndex();
+	void build(tmx::MapLoader& map);
+	void clear();
+	int getLayer(const std::string& layer_name);
+	const std::vector<tmx::MapObject*>& getObjects(int layer);
+
+private:
+
+	struct LayerEntry {
+		std::string name;
+		std::vector<tmx::MapObject*> objects;
+	};
+
+	std::vector<LayerEntry> layers;
+	std::vector<tmx::MapObject*> noObjects;
+};
+#endif
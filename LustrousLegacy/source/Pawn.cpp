@@ -12,6 +12,19 @@ Pawn::Pawn(const sf::Texture& imagePath):
 	pawnSprite.setTextureRect(sf::IntRect(spriteSource.x * spriteSize, spriteSource.y * spriteSize, spriteSize, spriteSize));
 }
 
+/*********************************************************************
+Pawn class constructor without a texture.
+\brief Sizes the sprite frames directly, for pawns that are never
+	   drawn. Creates no OpenGL resources, so it works without a window.
+\param Width and height of one frame of the sprite sheet.
+*********************************************************************/
+Pawn::Pawn(unsigned int sprite_size) :
+	spriteSource(Source::Idle, Direction::South),
+	spriteSize(sprite_size) {
+	pawnSprite.setOrigin(spriteSize*.5, spriteSize);
+	pawnSprite.setTextureRect(sf::IntRect(spriteSource.x * spriteSize, spriteSource.y * spriteSize, spriteSize, spriteSize));
+}
+
 /*********************************************************************
 Pawn class virtual destructor.
 *********************************************************************/
@@ -85,7 +98,9 @@ void Pawn::spriteAnimate(float elapsedTime) {
 		aniCounter -= aniFrameDuration;
 		spriteSource.x++;
 
-		if (spriteSource.x * spriteSize >= pawnSprite.getTexture()->getSize().x) {
+		// pawns without a texture animate over a sheet of three frames
+		unsigned int sheet_width = pawnSprite.getTexture() ? pawnSprite.getTexture()->getSize().x : 3 * spriteSize;
+		if (spriteSource.x * spriteSize >= sheet_width) {
 			spriteSource.x = 0;
 		}
 	}
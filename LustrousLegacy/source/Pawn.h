@@ -13,6 +13,7 @@ class Pawn : public sf::Drawable {
 public:
 
 	Pawn(const sf::Texture& playerTexture);
+	Pawn(unsigned int sprite_size);
 	virtual ~Pawn();
 	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
 	unsigned int getDirection();
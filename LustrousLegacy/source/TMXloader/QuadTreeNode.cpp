@@ -32,6 +32,8 @@ it freely, subject to the following restrictions:
 ///source for QuadTreeNode class///
 #include <tmx/QuadTreeNode.h>
 
+#include <algorithm>
+
 using namespace tmx;
 
 QuadTreeNode::QuadTreeNode(sf::Uint16 level, const sf::FloatRect& bounds)
@@ -56,31 +58,48 @@ void QuadTreeRoot::Clear(const sf::FloatRect& newBounds)
 
 std::vector<MapObject*> QuadTreeNode::Retrieve(const sf::FloatRect& bounds, sf::Uint16& searchDepth)
 {	
-	searchDepth = m_level;
-	std::vector<MapObject*> foundObjects;
-	sf::Int16 index = GetIndex(bounds);
-
-	//recursively add objects of child node if bounds is fully contained
-	if(!m_children.empty() && index != -1) 
-	{
-		foundObjects = m_children[index]->Retrieve(bounds, searchDepth);
-	}
-	else
+	//the search runs twice, once to count the objects found and once to copy
+	//them into a vector of that size. A query allocates a single vector rather
+	//than one per node visited, which were then concatenated on the way up
+	struct Search
 	{
-		//add all objects of child nodes which intersect test area
-		for(auto& child : m_children)
+		//a local class has the same access to nodes as this function
+		static void Visit(QuadTreeNode& node, const sf::FloatRect& bounds, sf::Uint16& searchDepth, std::size_t& count, MapObject** foundObjects)
 		{
-			if(bounds.intersects(child->m_bounds))
+			searchDepth = node.m_level;
+			sf::Int16 index = node.GetIndex(bounds);
+
+			//recursively add objects of child node if bounds is fully contained
+			if(!node.m_children.empty() && index != -1) 
+			{
+				Visit(*node.m_children[index], bounds, searchDepth, count, foundObjects);
+			}
+			else
 			{
-				std::vector<MapObject*> childObjects = child->Retrieve(bounds, searchDepth);
-				foundObjects.insert(foundObjects.end(), childObjects.begin(), childObjects.end());
+				//add all objects of child nodes which intersect test area
+				for(auto& child : node.m_children)
+				{
+					if(bounds.intersects(child->m_bounds))
+						Visit(*child, bounds, searchDepth, count, foundObjects);
+				}
+
 			}
+			//and append objects in this node
+			if(foundObjects)
+				std::copy(node.m_objects.begin(), node.m_objects.end(), foundObjects + count);
+			count += node.m_objects.size();
 		}
+	};
 
-	}
-	//and append objects in this node
-	foundObjects.insert(foundObjects.end(), m_objects.begin(), m_objects.end());
+	std::size_t count = 0u;
+	Search::Visit(*this, bounds, searchDepth, count, nullptr);
 
+	std::vector<MapObject*> foundObjects(count);
+	if(count > 0u)
+	{
+		count = 0u;
+		Search::Visit(*this, bounds, searchDepth, count, foundObjects.data());
+	}
 	return foundObjects;
 }
 
@@ -0,0 +1,309 @@
+/*********************************************************************
+Collision benchmark
+
+Runs the game's collision phase (sysCollision) on synthetic maps, so
+changes to CollisionGrid / CollisionMap can be measured without a
+window or the game's resources. Maps are generated as TMX text and
+loaded through MapLoader::LoadFromMemory, the same path a real map
+takes. Nothing is drawn and no OpenGL resources are created, so it
+runs on a headless machine.
+
+Build against the same sources as the game, minus main.cpp, e.g.
+	g++ -O2 -std=c++14 -I<tmx include> -Isource source/benchmark/CollisionBenchmark.cpp
+		source/Actor.cpp source/Pawn.cpp source/MapIndex.cpp source/CollisionGrid.cpp
+		source/CollisionMap.cpp source/CollisionPolygons.cpp source/CollisionSystem.cpp
+		source/TMXloader/DebugShape.cpp source/TMXloader/MapLayer.cpp
+		source/TMXloader/MapLoaderPrivate.cpp source/TMXloader/MapLoaderPublic.cpp
+		source/TMXloader/MapObject.cpp source/TMXloader/QuadTreeNode.cpp
+		source/TMXloader/pugixml/pugixml.cpp
+		-lsfml-graphics -lsfml-window -lsfml-system -lz
+
+Usage:
+	CollisionBenchmark [--polygons N] [--actors N] [--width TILES]
+		[--height TILES] [--ticks N] [--warmup N] [--seed N]
+		[--broadphase grid|loop]
+
+Reports per tick: time spent in sysCollision, heap allocations made by
+it and actor pairs the broadphase box-tested. --broadphase loop swaps
+CollisionGrid for the all pairs loop actorCollision ran before it, so
+both can be compared on the same map and actors.
+*********************************************************************/
+
+#include "../Actor.h"
+#include "../CollisionGrid.h"
+#include "../CollisionMap.h"
+#include "../CollisionSystem.h"
+#include "../Enums.h"
+#include "../MapIndex.h"
+#include "tmx/MapLoader.h"
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// every heap allocation in the process goes through these, the counter is
+// sampled around the collision phase only
+static unsigned long long allocationCount = 0;
+
+void* operator new(std::size_t size) {
+	allocationCount++;
+	if (void* memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+struct BenchmarkSettings {
+	unsigned int polygons = 400;
+	unsigned int actors = 200;
+	unsigned int width = 128;
+	unsigned int height = 128;
+	unsigned int ticks = 2000;
+	unsigned int warmup = 100;
+	unsigned int seed = 1;
+	bool loop = false;
+};
+
+/*********************************************************************
+\brief Reads the command line into settings. Returns false and prints
+	   usage on anything it does not understand.
+*********************************************************************/
+bool parseSettings(int argc, char** argv, BenchmarkSettings& settings) {
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) {
+			std::printf("missing value for %s\n", argv[i]);
+			return false;
+		}
+
+		std::string text = argv[i + 1];
+		unsigned int value = static_cast<unsigned int>(std::strtoul(text.c_str(), 0, 10));
+		std::string option = argv[i++];
+
+		if (option == "--broadphase" && (text == "grid" || text == "loop")) settings.loop = text == "loop";
+		else if (option == "--polygons") settings.polygons = value;
+		else if (option == "--actors") settings.actors = value;
+		else if (option == "--width") settings.width = value;
+		else if (option == "--height") settings.height = value;
+		else if (option == "--ticks") settings.ticks = value;
+		else if (option == "--warmup") settings.warmup = value;
+		else if (option == "--seed") settings.seed = value;
+		else {
+			std::printf("unknown option %s\n", option.c_str());
+			std::printf("usage: %s [--polygons N] [--actors N] [--width TILES] [--height TILES] [--ticks N] [--warmup N] [--seed N] [--broadphase grid|loop]\n", argv[0]);
+			return false;
+		}
+	}
+
+	if (settings.width == 0 || settings.height == 0) {
+		std::printf("map size must be at least one tile\n");
+		return false;
+	}
+	return true;
+}
+
+/*********************************************************************
+\brief Builds a TMX document with an empty tile set and a Collision
+	   object layer holding a mix of rectangles, triangles and
+	   concave polygons, one to four tiles across.
+*********************************************************************/
+std::string generateMap(const BenchmarkSettings& settings, std::mt19937& random) {
+	const int tile = System::Tilesize;
+	std::uniform_int_distribution<int> tile_x(0, settings.width - 1);
+	std::uniform_int_distribution<int> tile_y(0, settings.height - 1);
+	std::uniform_int_distribution<int> extent(1, 4);
+	std::uniform_int_distribution<int> shape(0, 2);
+
+	std::ostringstream map;
+	map << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<map version=\"1.0\" orientation=\"orthogonal\" width=\"" << settings.width << "\" height=\"" << settings.height
+		<< "\" tilewidth=\"" << tile << "\" tileheight=\"" << tile << "\">\n"
+		<< " <tileset firstgid=\"1\" name=\"benchmark\" tilewidth=\"" << tile << "\" tileheight=\"" << tile << "\"/>\n"
+		<< " <objectgroup name=\"Collision\">\n";
+
+	for (unsigned int i = 0; i < settings.polygons; i++) {
+		int x = tile_x(random) * tile;
+		int y = tile_y(random) * tile;
+		int w = extent(random) * tile;
+		int h = extent(random) * tile;
+
+		map << "  <object id=\"" << i + 1 << "\" x=\"" << x << "\" y=\"" << y << "\"";
+		switch (shape(random)) {
+		case 0:
+			map << " width=\"" << w << "\" height=\"" << h << "\"/>\n";
+			break;
+		case 1:
+			map << "><polygon points=\"0,0 " << w << "," << h / 2 << " " << w / 3 << "," << h << "\"/></object>\n";
+			break;
+		default:
+			map << "><polygon points=\"0,0 " << w << ",0 " << w / 2 << "," << h / 2 << " " << w << "," << h << " 0," << h << "\"/></object>\n";
+			break;
+		}
+	}
+
+	map << " </objectgroup>\n"
+		<< "</map>\n";
+	return map.str();
+}
+
+/*********************************************************************
+\brief Places actors on open ground and gives each a short patrol
+	   route, the same way NPCs are set up from a map's Setup layer.
+*********************************************************************/
+void spawnActors(const BenchmarkSettings& settings, std::mt19937& random, CollisionMap& collision, std::vector<Actor*>& actors) {
+	const float tile = static_cast<float>(System::Tilesize);
+	std::uniform_real_distribution<float> map_x(0.f, settings.width * tile);
+	std::uniform_real_distribution<float> map_y(0.f, settings.height * tile);
+	std::uniform_real_distribution<float> patrol(-6.f * tile, 6.f * tile);
+	std::uniform_int_distribution<int> waypoints(2, 4);
+
+	for (unsigned int i = 0; i < settings.actors; i++) {
+		sf::Vector2f position(map_x(random), map_y(random));
+		for (int attempt = 0; attempt < 32 && collision.blocked(position); attempt++)
+			position = sf::Vector2f(map_x(random), map_y(random));
+
+		Actor* actor = new Actor(System::Tilesize);
+		actor->setPosition(position);
+		actor->setPastPosition(position);
+
+		int count = waypoints(random);
+		for (int w = 0; w < count; w++)
+			actor->addTargetPosition(position + sf::Vector2f(patrol(random), patrol(random)));
+		actors.push_back(actor);
+	}
+}
+
+/*********************************************************************
+\brief The collision phase as it ran before CollisionGrid: every actor
+	   box-tested against every other, both orders of each pair, then
+	   the same sweep against the map sysCollision does. Returns the
+	   number of box tests.
+*********************************************************************/
+unsigned long long loopCollision(std::vector<Actor*>& actors, CollisionMap& collision) {
+	unsigned long long tested = 0;
+
+	for (auto actor = actors.begin(); actor != actors.end(); actor++) {
+		for (auto actor_check = actors.begin(); actor_check != actors.end(); actor_check++) {
+			tested++;
+			if ((*actor)->getCollisionBox().intersects((*actor_check)->getCollisionBox())) {
+				if ((*actor)->getPosition() != (*actor_check)->getPosition()) {
+					(*actor)->collided();
+					(*actor_check)->collided();
+				}
+			}
+		}
+	}
+
+	for (auto actor = actors.begin(); actor != actors.end(); actor++) {
+		sf::Vector2f resolved = collision.sweep((*actor)->getFrameStart(), (*actor)->getPosition());
+		if (resolved != (*actor)->getPosition())
+			(*actor)->setPosition(resolved);
+	}
+	return tested;
+}
+
+int main(int argc, char** argv) {
+	BenchmarkSettings settings;
+	if (!parseSettings(argc, argv, settings))
+		return 1;
+
+	tmx::Logger::SetLogLevel(tmx::Logger::Error);
+
+	std::mt19937 random(settings.seed);
+	std::string document = generateMap(settings, random);
+
+	tmx::MapLoader ml("");
+	if (!ml.LoadFromMemory(document)) {
+		std::printf("failed to load the generated map\n");
+		return 1;
+	}
+
+	MapIndex mapIndex;
+	CollisionMap collisionMap;
+	CollisionGrid actorGrid;
+
+	auto build_start = std::chrono::steady_clock::now();
+	mapIndex.build(ml);
+	collisionMap.build(ml, mapIndex.getObjects(mapIndex.getLayer("Collision")));
+	auto build_end = std::chrono::steady_clock::now();
+
+	// actors never draw here, their collision box is sized from frames of
+	// one tile like the game's sprite sheets
+	std::vector<Actor*> actors;
+	spawnActors(settings, random, collisionMap, actors);
+
+	// the game measures frame time in milliseconds
+	const float elapsedTime = 16.f;
+
+	std::chrono::nanoseconds collision_time(0);
+	unsigned long long allocations = 0;
+	unsigned long long pairs_tested = 0;
+
+	for (unsigned int tick = 0; tick < settings.warmup + settings.ticks; tick++) {
+		for (auto actor = actors.begin(); actor != actors.end(); actor++) {
+			(*actor)->startFrame();
+			(*actor)->cycleMovement(elapsedTime);
+		}
+
+		unsigned long long allocations_before = allocationCount;
+		auto start = std::chrono::steady_clock::now();
+
+		unsigned long long tested;
+		if (settings.loop) {
+			tested = loopCollision(actors, collisionMap);
+		}
+		else {
+			sysCollision(actors, collisionMap, actorGrid);
+			tested = actorGrid.getPairsTested();
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		// warmup ticks let the reusable buffers reach their working size
+		if (tick < settings.warmup)
+			continue;
+
+		collision_time += end - start;
+		allocations += allocationCount - allocations_before;
+		pairs_tested += tested;
+	}
+
+	double ticks = settings.ticks ? static_cast<double>(settings.ticks) : 1.0;
+
+	std::printf("map           %u x %u tiles, %u collision polygons\n", settings.width, settings.height, settings.polygons);
+	std::printf("actors        %u\n", settings.actors);
+	std::printf("broadphase    %s\n", settings.loop ? "loop" : "grid");
+	std::printf("ticks         %u (+%u warmup)\n", settings.ticks, settings.warmup);
+	std::printf("build         %.3f ms\n", std::chrono::duration<double, std::milli>(build_end - build_start).count());
+	std::printf("ns/tick       %.0f\n", collision_time.count() / ticks);
+	std::printf("allocs/tick   %.2f\n", allocations / ticks);
+	std::printf("pairs/tick    %.1f\n", pairs_tested / ticks);
+
+	for (auto actor = actors.begin(); actor != actors.end(); actor++)
+		delete *actor;
+	return 0;
+}
@@ -0,0 +1,173 @@
+/*********************************************************************
+Collision polygons test
+
+Checks CollisionPolygons::contains and containsBatch, which run four
+edges or four points at a time where SSE2 is available, against
+MapObject::Contains on random polygons. Polygons have three to eleven
+points, so every amount of edge padding is covered, and batches are
+sized so the scalar tail of containsBatch runs too. Test points include
+the polygon's own vertices, points level with each vertex and points
+level with local y = 0, where the horizontal padding edges lie.
+
+Build against the TMX loader, e.g.
+	g++ -O2 -std=c++14 -I<tmx include> -Isource source/benchmark/CollisionPolygonsTest.cpp
+		source/CollisionPolygons.cpp
+		source/TMXloader/DebugShape.cpp source/TMXloader/MapLayer.cpp
+		source/TMXloader/MapLoaderPrivate.cpp source/TMXloader/MapLoaderPublic.cpp
+		source/TMXloader/MapObject.cpp source/TMXloader/QuadTreeNode.cpp
+		source/TMXloader/pugixml/pugixml.cpp
+		-lsfml-graphics -lsfml-window -lsfml-system -lz
+
+Usage:
+	CollisionPolygonsTest [--polygons N] [--points N] [--seed N]
+
+Prints the number of mismatches and exits with 1 if there were any.
+*********************************************************************/
+
+#include "../CollisionPolygons.h"
+#include "tmx/MapLoader.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct TestSettings {
+	unsigned int polygons = 500;
+	unsigned int points = 2000;
+	unsigned int seed = 1;
+};
+
+/*********************************************************************
+\brief Reads the command line into settings. Returns false and prints
+	   usage on anything it does not understand.
+*********************************************************************/
+bool parseSettings(int argc, char** argv, TestSettings& settings) {
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) {
+			std::printf("missing value for %s\n", argv[i]);
+			return false;
+		}
+
+		unsigned int value = static_cast<unsigned int>(std::strtoul(argv[i + 1], 0, 10));
+		std::string option = argv[i++];
+
+		if (option == "--polygons") settings.polygons = value;
+		else if (option == "--points") settings.points = value;
+		else if (option == "--seed") settings.seed = value;
+		else {
+			std::printf("unknown option %s\n", option.c_str());
+			std::printf("usage: %s [--polygons N] [--points N] [--seed N]\n", argv[0]);
+			return false;
+		}
+	}
+	return true;
+}
+
+/*********************************************************************
+\brief Builds a TMX document with one object layer of random, mostly
+	   concave and self intersecting polygons of 3 to 11 points.
+*********************************************************************/
+std::string generateMap(const TestSettings& settings, std::mt19937& random) {
+	std::uniform_int_distribution<int> position(0, 1000);
+	std::uniform_int_distribution<int> point(0, 200);
+	std::uniform_int_distribution<int> count(3, 11);
+
+	std::ostringstream map;
+	map << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<map version=\"1.0\" orientation=\"orthogonal\" width=\"20\" height=\"20\" tilewidth=\"64\" tileheight=\"64\">\n"
+		<< " <tileset firstgid=\"1\" name=\"test\" tilewidth=\"64\" tileheight=\"64\"/>\n"
+		<< " <objectgroup name=\"Collision\">\n";
+
+	for (unsigned int i = 0; i < settings.polygons; i++) {
+		map << "  <object id=\"" << i + 1 << "\" x=\"" << position(random) << "\" y=\"" << position(random) << "\"><polygon points=\"";
+		int points = count(random);
+		for (int p = 0; p < points; p++)
+			map << (p ? " " : "") << point(random) << "," << point(random);
+		map << "\"/></object>\n";
+	}
+
+	map << " </objectgroup>\n"
+		<< "</map>\n";
+	return map.str();
+}
+
+int main(int argc, char** argv) {
+	TestSettings settings;
+	if (!parseSettings(argc, argv, settings))
+		return 1;
+
+	tmx::Logger::SetLogLevel(tmx::Logger::Error);
+
+	std::mt19937 random(settings.seed);
+	std::string document = generateMap(settings, random);
+
+	tmx::MapLoader ml("");
+	if (!ml.LoadFromMemory(document)) {
+		std::printf("failed to load the generated map\n");
+		return 1;
+	}
+
+	std::vector<tmx::MapObject*> objects;
+	for (auto layer = ml.GetLayers().begin(); layer != ml.GetLayers().end(); ++layer) {
+		for (auto object = layer->objects.begin(); object != layer->objects.end(); ++object)
+			objects.push_back(&*object);
+	}
+
+	CollisionPolygons polygons;
+	for (auto object = objects.begin(); object != objects.end(); ++object)
+		polygons.add(**object);
+
+	std::uniform_real_distribution<float> offset(-20.f, 220.f);
+	std::uniform_int_distribution<unsigned int> batch_size(1, 11);
+
+	unsigned long long tested = 0;
+	unsigned long long single_mismatches = 0;
+	unsigned long long batch_mismatches = 0;
+
+	for (unsigned int polygon = 0; polygon < objects.size(); polygon++) {
+		const tmx::MapObject& object = *objects[polygon];
+		const std::vector<sf::Vector2f>& outline = object.PolyPoints();
+		sf::Vector2f origin = object.GetPosition();
+
+		std::vector<sf::Vector2f> points;
+		for (unsigned int i = 0; i < settings.points; i++)
+			points.push_back(origin + sf::Vector2f(offset(random), offset(random)));
+		for (auto vertex = outline.begin(); vertex != outline.end(); ++vertex) {
+			points.push_back(origin + *vertex);
+			points.push_back(origin + sf::Vector2f(offset(random), vertex->y));
+		}
+		// level with the padding edges, which sit at local y = 0
+		for (unsigned int i = 0; i < 16; i++)
+			points.push_back(origin + sf::Vector2f(offset(random), 0.f));
+
+		std::vector<char> batch_results(points.size());
+		bool results[11];
+
+		for (unsigned int first = 0; first < points.size();) {
+			unsigned int count = std::min(batch_size(random), static_cast<unsigned int>(points.size()) - first);
+			polygons.containsBatch(polygon, &points[first], count, results);
+			for (unsigned int i = 0; i < count; i++)
+				batch_results[first + i] = results[i];
+			first += count;
+		}
+
+		for (unsigned int i = 0; i < points.size(); i++) {
+			bool expected = object.Contains(points[i]);
+			if (polygons.contains(polygon, points[i]) != expected)
+				single_mismatches++;
+			if ((batch_results[i] != 0) != expected)
+				batch_mismatches++;
+			tested++;
+		}
+	}
+
+	std::printf("polygons      %u\n", polygons.size());
+	std::printf("points        %llu\n", tested);
+	std::printf("contains      %llu mismatches\n", single_mismatches);
+	std::printf("containsBatch %llu mismatches\n", batch_mismatches);
+	return single_mismatches || batch_mismatches ? 1 : 0;
+}
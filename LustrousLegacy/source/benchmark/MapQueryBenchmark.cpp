@@ -0,0 +1,184 @@
+/*********************************************************************
+Map query benchmark
+
+Fills the TMX loader's object quad tree from a synthetic map and runs
+MapLoader::QueryQuadTree over it, counting the heap allocations a
+single query makes. Maps are generated as TMX text and loaded through
+MapLoader::LoadFromMemory, the same path a real map takes. Runs
+headlessly, nothing is drawn.
+
+Build against the TMX loader, e.g.
+	g++ -O2 -std=c++14 -I<tmx include> -Isource source/benchmark/MapQueryBenchmark.cpp
+		source/TMXloader/DebugShape.cpp source/TMXloader/MapLayer.cpp
+		source/TMXloader/MapLoaderPrivate.cpp source/TMXloader/MapLoaderPublic.cpp
+		source/TMXloader/MapObject.cpp source/TMXloader/QuadTreeNode.cpp
+		source/TMXloader/pugixml/pugixml.cpp
+		-lsfml-graphics -lsfml-window -lsfml-system -lz
+
+Usage:
+	MapQueryBenchmark [--objects N] [--width TILES] [--height TILES]
+		[--queries N] [--extent TILES] [--seed N]
+
+Reports per query: time, heap allocations and objects returned. Query
+areas are square, --extent tiles across.
+*********************************************************************/
+
+#include "../Enums.h"
+#include "tmx/MapLoader.h"
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// every heap allocation in the process goes through these, the counter is
+// sampled around the queries only
+static unsigned long long allocationCount = 0;
+
+void* operator new(std::size_t size) {
+	allocationCount++;
+	if (void* memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+struct BenchmarkSettings {
+	unsigned int objects = 2000;
+	unsigned int width = 128;
+	unsigned int height = 128;
+	unsigned int queries = 20000;
+	unsigned int extent = 2;
+	unsigned int seed = 1;
+};
+
+/*********************************************************************
+\brief Reads the command line into settings. Returns false and prints
+	   usage on anything it does not understand.
+*********************************************************************/
+bool parseSettings(int argc, char** argv, BenchmarkSettings& settings) {
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) {
+			std::printf("missing value for %s\n", argv[i]);
+			return false;
+		}
+
+		unsigned int value = static_cast<unsigned int>(std::strtoul(argv[i + 1], 0, 10));
+		std::string option = argv[i++];
+
+		if (option == "--objects") settings.objects = value;
+		else if (option == "--width") settings.width = value;
+		else if (option == "--height") settings.height = value;
+		else if (option == "--queries") settings.queries = value;
+		else if (option == "--extent") settings.extent = value;
+		else if (option == "--seed") settings.seed = value;
+		else {
+			std::printf("unknown option %s\n", option.c_str());
+			std::printf("usage: %s [--objects N] [--width TILES] [--height TILES] [--queries N] [--extent TILES] [--seed N]\n", argv[0]);
+			return false;
+		}
+	}
+
+	if (settings.width == 0 || settings.height == 0) {
+		std::printf("map size must be at least one tile\n");
+		return false;
+	}
+	return true;
+}
+
+/*********************************************************************
+\brief Builds a TMX document with an empty tile set and one object
+	   layer of rectangles, one to four tiles across.
+*********************************************************************/
+std::string generateMap(const BenchmarkSettings& settings, std::mt19937& random) {
+	const int tile = System::Tilesize;
+	std::uniform_int_distribution<int> tile_x(0, settings.width - 1);
+	std::uniform_int_distribution<int> tile_y(0, settings.height - 1);
+	std::uniform_int_distribution<int> extent(1, 4);
+
+	std::ostringstream map;
+	map << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<map version=\"1.0\" orientation=\"orthogonal\" width=\"" << settings.width << "\" height=\"" << settings.height
+		<< "\" tilewidth=\"" << tile << "\" tileheight=\"" << tile << "\">\n"
+		<< " <tileset firstgid=\"1\" name=\"benchmark\" tilewidth=\"" << tile << "\" tileheight=\"" << tile << "\"/>\n"
+		<< " <objectgroup name=\"Collision\">\n";
+
+	for (unsigned int i = 0; i < settings.objects; i++) {
+		map << "  <object id=\"" << i + 1 << "\" x=\"" << tile_x(random) * tile << "\" y=\"" << tile_y(random) * tile
+			<< "\" width=\"" << extent(random) * tile << "\" height=\"" << extent(random) * tile << "\"/>\n";
+	}
+
+	map << " </objectgroup>\n"
+		<< "</map>\n";
+	return map.str();
+}
+
+int main(int argc, char** argv) {
+	BenchmarkSettings settings;
+	if (!parseSettings(argc, argv, settings))
+		return 1;
+
+	tmx::Logger::SetLogLevel(tmx::Logger::Error);
+
+	std::mt19937 random(settings.seed);
+	std::string document = generateMap(settings, random);
+
+	tmx::MapLoader ml("");
+	if (!ml.LoadFromMemory(document)) {
+		std::printf("failed to load the generated map\n");
+		return 1;
+	}
+
+	const float tile = static_cast<float>(System::Tilesize);
+	sf::Vector2f map_size(settings.width * tile, settings.height * tile);
+	ml.UpdateQuadTree(sf::FloatRect(0.f, 0.f, map_size.x, map_size.y));
+
+	float extent = settings.extent * tile;
+	std::uniform_real_distribution<float> area_x(-extent, map_size.x);
+	std::uniform_real_distribution<float> area_y(-extent, map_size.y);
+	std::vector<sf::FloatRect> areas;
+	for (unsigned int i = 0; i < settings.queries; i++)
+		areas.push_back(sf::FloatRect(area_x(random), area_y(random), extent, extent));
+
+	unsigned long long found = 0;
+	unsigned long long allocations_before = allocationCount;
+	auto start = std::chrono::steady_clock::now();
+
+	for (auto area = areas.begin(); area != areas.end(); area++)
+		found += ml.QueryQuadTree(*area).size();
+
+	auto end = std::chrono::steady_clock::now();
+	unsigned long long allocations = allocationCount - allocations_before;
+
+	double queries = settings.queries ? static_cast<double>(settings.queries) : 1.0;
+
+	std::printf("map           %u x %u tiles, %u objects\n", settings.width, settings.height, settings.objects);
+	std::printf("queries       %u, %u x %u tiles\n", settings.queries, settings.extent, settings.extent);
+	std::printf("ns/query      %.0f\n", std::chrono::duration<double, std::nano>(end - start).count() / queries);
+	std::printf("allocs/query  %.2f\n", allocations / queries);
+	std::printf("found/query   %.1f\n", found / queries);
+	return 0;
+}
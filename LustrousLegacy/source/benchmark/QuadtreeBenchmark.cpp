@@ -0,0 +1,179 @@
+/*********************************************************************
+Quadtree benchmark
+
+Fills an ltbl::StaticQuadtree with tile sized shapes the way a map's
+light blocking tiles would be, once through add() per shape and once
+through the bulk build(), and times building and querying both trees.
+Runs headlessly, nothing is drawn.
+
+Build against the lighting library, e.g.
+	g++ -O2 -std=c++14 -I. source/benchmark/QuadtreeBenchmark.cpp
+		ltbl/quadtree/DynamicQuadtree.cpp ltbl/quadtree/Quadtree.cpp
+		ltbl/quadtree/QuadtreeN.cpp ltbl/quadtree/QuadtreeNodePool.cpp
+		ltbl/quadtree/QuadtreeOccupant.cpp ltbl/quadtree/QuadtreeStats.cpp
+		ltbl/quadtree/StaticQuadtree.cpp ltbl/Math.cpp
+		-lsfml-graphics -lsfml-window -lsfml-system
+
+Usage:
+	QuadtreeBenchmark [--shapes N] [--width TILES] [--height TILES]
+		[--queries N] [--seed N]
+
+Reports build time for each tree and the average time of a view
+sized region query, followed by the statistics of both trees as JSON
+for tuning the quadtree settings.
+*********************************************************************/
+
+#include "../Enums.h"
+#include <ltbl/quadtree/StaticQuadtree.h>
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+struct BenchmarkSettings {
+	unsigned int shapes = 10000;
+	unsigned int width = 256;
+	unsigned int height = 256;
+	unsigned int queries = 2000;
+	unsigned int seed = 1;
+};
+
+/*********************************************************************
+\brief A fixed rectangle standing in for a light blocking shape.
+*********************************************************************/
+class BenchmarkShape : public ltbl::QuadtreeOccupant {
+public:
+
+	BenchmarkShape(const sf::FloatRect& bounds) :
+		bounds(bounds) {
+	}
+
+	sf::FloatRect getAABB() const {
+		return bounds;
+	}
+
+private:
+
+	sf::FloatRect bounds;
+};
+
+/*********************************************************************
+\brief Reads the command line into settings. Returns false and prints
+	   usage on anything it does not understand.
+*********************************************************************/
+bool parseSettings(int argc, char** argv, BenchmarkSettings& settings) {
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) {
+			std::printf("missing value for %s\n", argv[i]);
+			return false;
+		}
+
+		unsigned int value = static_cast<unsigned int>(std::strtoul(argv[i + 1], 0, 10));
+		std::string option = argv[i++];
+
+		if (option == "--shapes") settings.shapes = value;
+		else if (option == "--width") settings.width = value;
+		else if (option == "--height") settings.height = value;
+		else if (option == "--queries") settings.queries = value;
+		else if (option == "--seed") settings.seed = value;
+		else {
+			std::printf("unknown option %s\n", option.c_str());
+			std::printf("usage: %s [--shapes N] [--width TILES] [--height TILES] [--queries N] [--seed N]\n", argv[0]);
+			return false;
+		}
+	}
+
+	if (settings.width == 0 || settings.height == 0) {
+		std::printf("map size must be at least one tile\n");
+		return false;
+	}
+	return true;
+}
+
+/*********************************************************************
+\brief Runs the same view sized queries against a tree and returns
+	   the average time of one in microseconds. found counts the
+	   shapes returned so both trees can be checked against each other.
+*********************************************************************/
+double timeQueries(const ltbl::Quadtree& tree, const std::vector<sf::FloatRect>& views, unsigned long long& found) {
+	std::vector<ltbl::QuadtreeOccupant*> results;
+	found = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (auto view = views.begin(); view != views.end(); view++) {
+		results.clear();
+		tree.queryRegion(results, *view);
+		found += results.size();
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::micro>(end - start).count() / (views.empty() ? 1 : views.size());
+}
+
+int main(int argc, char** argv) {
+	BenchmarkSettings settings;
+	if (!parseSettings(argc, argv, settings))
+		return 1;
+
+	const float tile = static_cast<float>(System::Tilesize);
+	std::mt19937 random(settings.seed);
+	std::uniform_int_distribution<unsigned int> tile_x(0, settings.width - 1);
+	std::uniform_int_distribution<unsigned int> tile_y(0, settings.height - 1);
+	std::uniform_int_distribution<unsigned int> extent(1, 3);
+
+	std::vector<BenchmarkShape> shapes;
+	shapes.reserve(settings.shapes);
+	for (unsigned int i = 0; i < settings.shapes; i++)
+		shapes.push_back(BenchmarkShape(sf::FloatRect(tile_x(random) * tile, tile_y(random) * tile, extent(random) * tile, tile)));
+
+	// one screen of the game around random points of the map
+	std::vector<sf::FloatRect> views;
+	for (unsigned int i = 0; i < settings.queries; i++)
+		views.push_back(sf::FloatRect(tile_x(random) * tile - 8.f * tile, tile_y(random) * tile - 6.f * tile, 16.f * tile, 12.f * tile));
+
+	sf::FloatRect map_bounds(0.f, 0.f, settings.width * tile, settings.height * tile);
+
+	ltbl::StaticQuadtree added(map_bounds);
+	auto add_start = std::chrono::steady_clock::now();
+	for (auto shape = shapes.begin(); shape != shapes.end(); shape++)
+		added.add(&*shape);
+	auto add_end = std::chrono::steady_clock::now();
+
+	// the shapes now belong to the first tree, a second set goes into the bulk tree
+	std::vector<BenchmarkShape> bulk_shapes(shapes);
+	std::vector<BenchmarkShape*> bulk_pointers;
+	for (auto shape = bulk_shapes.begin(); shape != bulk_shapes.end(); shape++)
+		bulk_pointers.push_back(&*shape);
+
+	ltbl::StaticQuadtree built(map_bounds);
+	auto build_start = std::chrono::steady_clock::now();
+	built.build(bulk_pointers.begin(), bulk_pointers.end());
+	auto build_end = std::chrono::steady_clock::now();
+
+	unsigned long long added_found;
+	unsigned long long built_found;
+	double added_query = timeQueries(added, views, added_found);
+	double built_query = timeQueries(built, views, built_found);
+
+	// the query counters are left out of the timing, the same queries run again for them
+	added._recordQueryStats = true;
+	built._recordQueryStats = true;
+	timeQueries(added, views, added_found);
+	timeQueries(built, views, built_found);
+
+	std::printf("map           %u x %u tiles, %u shapes\n", settings.width, settings.height, settings.shapes);
+	std::printf("queries       %u\n", settings.queries);
+	std::printf("add           %.3f ms build, %.2f us/query\n", std::chrono::duration<double, std::milli>(add_end - add_start).count(), added_query);
+	std::printf("bulk build    %.3f ms build, %.2f us/query, %u nodes\n", std::chrono::duration<double, std::milli>(build_end - build_start).count(), built_query, static_cast<unsigned int>(built.getNumBulkNodes()));
+	std::printf("add stats     %s\n", added.getStats().toJson().c_str());
+	std::printf("bulk stats    %s\n", built.getStats().toJson().c_str());
+
+	if (added_found != built_found) {
+		std::printf("trees disagree: %llu shapes found by add, %llu by bulk build\n", added_found, built_found);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,211 @@
+/*********************************************************************
+Quadtree stress test
+
+Exercises the quadtree threading contract: one thread moves shapes
+and updates the trees, then many threads query the frozen trees at
+once. A DynamicQuadtree and a bulk built StaticQuadtree are queried
+by region, point and shape, and every result is checked against a
+brute force search of the same shapes. Build it with ThreadSanitizer
+so data races are reported as well as wrong results.
+
+Build against the lighting library, e.g.
+	g++ -O1 -g -std=c++14 -fsanitize=thread -pthread -I. source/benchmark/QuadtreeStressTest.cpp
+		ltbl/quadtree/DynamicQuadtree.cpp ltbl/quadtree/Quadtree.cpp
+		ltbl/quadtree/QuadtreeN.cpp ltbl/quadtree/QuadtreeNodePool.cpp
+		ltbl/quadtree/QuadtreeOccupant.cpp ltbl/quadtree/QuadtreeStats.cpp
+		ltbl/quadtree/StaticQuadtree.cpp ltbl/Math.cpp
+		-lsfml-graphics -lsfml-window -lsfml-system
+
+Usage:
+	QuadtreeStressTest [--shapes N] [--threads N] [--queries N]
+		[--phases N] [--seed N]
+
+Prints the number of queries and mismatches and exits with 1 if there
+were any.
+*********************************************************************/
+
+#include <ltbl/quadtree/DynamicQuadtree.h>
+#include <ltbl/quadtree/StaticQuadtree.h>
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct TestSettings {
+	unsigned int shapes = 5000;
+	unsigned int threads = 8;
+	unsigned int queries = 3000;
+	unsigned int phases = 3;
+	unsigned int seed = 1;
+};
+
+/*********************************************************************
+\brief A rectangle the writer phase is free to move.
+*********************************************************************/
+class StressShape : public ltbl::QuadtreeOccupant {
+public:
+
+	StressShape(const sf::FloatRect& bounds) :
+		bounds(bounds) {
+	}
+
+	sf::FloatRect getAABB() const {
+		return bounds;
+	}
+
+	sf::FloatRect bounds;
+};
+
+/*********************************************************************
+\brief Reads the command line into settings. Returns false and prints
+	   usage on anything it does not understand.
+*********************************************************************/
+bool parseSettings(int argc, char** argv, TestSettings& settings) {
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) {
+			std::printf("missing value for %s\n", argv[i]);
+			return false;
+		}
+
+		unsigned int value = static_cast<unsigned int>(std::strtoul(argv[i + 1], 0, 10));
+		std::string option = argv[i++];
+
+		if (option == "--shapes") settings.shapes = value;
+		else if (option == "--threads") settings.threads = value;
+		else if (option == "--queries") settings.queries = value;
+		else if (option == "--phases") settings.phases = value;
+		else if (option == "--seed") settings.seed = value;
+		else {
+			std::printf("unknown option %s\n", option.c_str());
+			std::printf("usage: %s [--shapes N] [--threads N] [--queries N] [--phases N] [--seed N]\n", argv[0]);
+			return false;
+		}
+	}
+	return true;
+}
+
+/*********************************************************************
+\brief Runs one reader's queries, alternating between both trees and
+	   cycling through region, point and shape queries. Returns the
+	   number of queries whose result count differs from brute force.
+*********************************************************************/
+unsigned long long readQueries(const ltbl::DynamicQuadtree& dynamic_tree, const std::vector<StressShape*>& dynamic_shapes,
+	const ltbl::StaticQuadtree& static_tree, const std::vector<StressShape*>& static_shapes,
+	const ltbl::ShapeAxes& axes, unsigned int queries, unsigned int seed) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(0.f, 1000.f);
+	std::uniform_real_distribution<float> extent(0.f, 100.f);
+
+	std::vector<ltbl::QuadtreeOccupant*> results;
+	unsigned long long mismatches = 0;
+
+	for (unsigned int i = 0; i < queries; i++) {
+		bool use_dynamic = (i & 1) != 0;
+		const ltbl::Quadtree& tree = use_dynamic ? static_cast<const ltbl::Quadtree&>(dynamic_tree) : static_tree;
+		const std::vector<StressShape*>& shapes = use_dynamic ? dynamic_shapes : static_shapes;
+
+		sf::FloatRect region(position(random), position(random), extent(random), extent(random));
+		sf::Vector2f point(region.left, region.top);
+		size_t expected = 0;
+		results.clear();
+
+		switch (i % 3) {
+		case 0:
+			tree.queryRegion(results, region);
+			for (auto shape = shapes.begin(); shape != shapes.end(); shape++)
+				if (region.intersects((*shape)->bounds)) expected++;
+			break;
+		case 1:
+			tree.queryPoint(results, point);
+			for (auto shape = shapes.begin(); shape != shapes.end(); shape++)
+				if ((*shape)->bounds.contains(point)) expected++;
+			break;
+		default:
+			tree.queryShape(results, axes);
+			for (auto shape = shapes.begin(); shape != shapes.end(); shape++)
+				if (axes.intersects((*shape)->bounds)) expected++;
+			break;
+		}
+
+		if (results.size() != expected)
+			mismatches++;
+	}
+	return mismatches;
+}
+
+int main(int argc, char** argv) {
+	TestSettings settings;
+	if (!parseSettings(argc, argv, settings))
+		return 1;
+
+	std::mt19937 random(settings.seed);
+	std::uniform_real_distribution<float> position(0.f, 1000.f);
+	std::uniform_real_distribution<float> size(1.f, 21.f);
+
+	std::vector<StressShape> dynamic_storage;
+	std::vector<StressShape> static_storage;
+	dynamic_storage.reserve(settings.shapes);
+	static_storage.reserve(settings.shapes);
+	for (unsigned int i = 0; i < settings.shapes; i++) {
+		sf::FloatRect bounds(position(random), position(random), size(random), size(random));
+		dynamic_storage.push_back(StressShape(bounds));
+		static_storage.push_back(StressShape(bounds));
+	}
+
+	std::vector<StressShape*> dynamic_shapes;
+	std::vector<StressShape*> static_shapes;
+	for (unsigned int i = 0; i < settings.shapes; i++) {
+		dynamic_shapes.push_back(&dynamic_storage[i]);
+		static_shapes.push_back(&static_storage[i]);
+	}
+
+	// the dynamic tree starts small so adding expands it and trim shrinks it again
+	ltbl::DynamicQuadtree dynamic_tree(sf::FloatRect(0.f, 0.f, 4.f, 4.f));
+	for (auto shape = dynamic_shapes.begin(); shape != dynamic_shapes.end(); shape++)
+		dynamic_tree.add(*shape);
+	dynamic_tree.trim();
+
+	ltbl::StaticQuadtree static_tree;
+	static_tree.build(static_shapes.begin(), static_shapes.end());
+
+	std::atomic<unsigned long long> mismatches(0);
+	unsigned long long queries = 0;
+	unsigned int moved = std::min<unsigned int>(500, settings.shapes);
+
+	for (unsigned int phase = 0; phase < settings.phases; phase++) {
+		// single writer
+		for (unsigned int i = 0; i < moved; i++) {
+			dynamic_storage[i].bounds.left = position(random);
+			dynamic_storage[i].quadtreeMarkDirty();
+		}
+		dynamic_tree.updateDirtyOccupants();
+
+		sf::ConvexShape shape = ltbl::shapeFromRect(sf::FloatRect(0.f, 0.f, 300.f, 50.f));
+		shape.setPosition(500.f, 500.f);
+		shape.setRotation(30.f * phase);
+		ltbl::ShapeAxes axes(shape);
+
+		// many readers
+		std::vector<std::thread> readers;
+		for (unsigned int t = 0; t < settings.threads; t++) {
+			unsigned int seed = settings.seed + phase * settings.threads + t + 1;
+			readers.push_back(std::thread([&, seed] {
+				mismatches += readQueries(dynamic_tree, dynamic_shapes, static_tree, static_shapes, axes, settings.queries, seed);
+			}));
+		}
+		for (auto reader = readers.begin(); reader != readers.end(); reader++)
+			reader->join();
+
+		queries += static_cast<unsigned long long>(settings.threads) * settings.queries;
+	}
+
+	std::printf("shapes        %u\n", settings.shapes);
+	std::printf("queries       %llu on %u threads\n", queries, settings.threads);
+	std::printf("mismatches    %llu\n", mismatches.load());
+	return mismatches.load() ? 1 : 0;
+}
@@ -41,21 +41,25 @@ http://trederia.blogspot.com/2013/05/tiled-map-loader-for-sfml.html
 #include "Step.h"
 #include "Event.h"
 #include "BattleSystem.h"
+#include "CollisionGrid.h"
+#include "CollisionMap.h"
+#include "CollisionSystem.h"
+#include "ActorRegions.h"
+#include "MapIndex.h"
 
 using namespace std;
 
 // MAIN FUNCTIONS
-void sysCollision(std::vector<Actor*>& actors, tmx::MapLoader& map);
-void actorCollision(std::vector<Actor*>&);
 bool UI_visible(std::vector<UI*>& sysWindows);
 bool UI_visible_excluding(UI* sysWindow, std::vector<UI*> sysWindows);
-void load_map(tmx::MapLoader& ml, std::string map_name, Character& player, std::vector<Actor*>& actors, std::vector<Pawn*>& pawns, std::map<std::string, sf::Texture*> texMap);
+void load_map(tmx::MapLoader& ml, MapIndex& index, CollisionMap& collision, std::string map_name, Character& player, std::vector<Actor*>& actors, std::vector<Pawn*>& pawns, std::map<std::string, sf::Texture*> texMap);
 void animateMap(tmx::MapLoader& ml, sf::RenderWindow& window, float(&worldAnimationArr)[3]);
 void drawTextbox(sf::RenderWindow& window, Textbox* textbox, bool flag);
 void drawEntities(sf::RenderWindow& window, std::vector<Pawn*>& entities);
 void drawUI(sf::RenderWindow& window, sf::View playerView, std::vector<UI*>& sysWindows, float elapsedTime);
 sf::Vector2f Vector2iTo2f(sf::Vector2i pos);
 sf::Vector2f tile(int tile_row, int tile_column);
+sf::FloatRect interactionReach(Actor& actor);
 
 // TEMP -> DEPTH SORT CLASS
 class byDepth
@@ -223,6 +227,8 @@ int main() {
 	*********************************************************************/
 
 	tmx::MapLoader ml("resources/maps");
+	MapIndex mapIndex;
+	CollisionMap collisionMap;
 	std::string map_name = "start.tmx";
 	std::string current_map = "";
 
@@ -264,6 +270,13 @@ int main() {
 	std::vector<Pawn*> entities;
 	actors.push_back(&player);
 
+	// broadphase for actor vs actor collision, also queried for interaction
+	CollisionGrid actorGrid;
+	std::vector<Actor*> nearbyActors;
+
+	// only actors around the camera are simulated, the rest sleep
+	ActorRegions actorRegions;
+
 
 	/*********************************************************************
 	UI KEYBOARD INPUT
@@ -385,7 +398,8 @@ int main() {
 
 		if (current_map != map_name && initial_load_map)
 		{
-			load_map(ml, map_name, player, actors, entities, textureMap);
+			load_map(ml, mapIndex, collisionMap, map_name, player, actors, entities, textureMap);
+			actorRegions.build(actors, ml.GetMapSize());
 			for (int i = actors.size(); i != 0; i--) {
 				entities.push_back(actors[i - 1]);
 			}
@@ -407,13 +421,23 @@ int main() {
 				}
 				else {
 					// *************** End Audrey Edit *************** //
+					actorRegions.update(playerView);
+					std::vector<Actor*>& awakeActors = actorRegions.getAwake();
+
+					// collision sweeps run from where every actor starts the frame
+					player.startFrame();
+					for (auto actor = awakeActors.begin(); actor != awakeActors.end(); actor++)
+						(*actor)->startFrame();
+
 					player.move(elapsedTime, player.controller.get_input());
-					sysCollision(actors, ml);
+					sysCollision(awakeActors, collisionMap, actorGrid);
 
 					// TEST INTERACTION BETWEEN PLAYER AND OTHER ACTORS
-					for (auto actor = actors.begin(); actor != actors.end(); actor++)
+					// only actors the broadphase holds around the player can be in reach
+					actorGrid.query(interactionReach(player), nearbyActors);
+					for (auto actor = nearbyActors.begin(); actor != nearbyActors.end(); actor++)
 					{
-						if ((*actor)->getClass() != "Character") {
+						if (*actor != &player) {
 							textbox = player.check_Interact(**actor);
 							if (textbox) {
 								message[1] = (*actor)->getScene();
@@ -459,41 +483,16 @@ int main() {
 }
 
 /*********************************************************************
-/brief Performs the collision between actors.
+\brief Returns the area of the actor grid holding every actor whose
+	   sprite could overlap this actor's sprite. Sprites are at most a
+	   tile across and the grid stores collision boxes, which keep the
+	   same offset from every sprite. The extra half tile covers any
+	   movement resolved after the grid was built this frame.
 *********************************************************************/
-void actorCollision(std::vector<Actor*>& actors)
-{
-	for (auto actor = actors.begin(); actor != actors.end(); actor++) {
-		for (auto actor_check = actors.begin(); actor_check != actors.end(); actor_check++) {
-			if ((*actor)->getCollisionBox().intersects((*actor_check)->getCollisionBox())) {
-				if ((*actor)->getPosition() != (*actor_check)->getPosition()) {
-					(*actor)->collided();
-					(*actor_check)->collided();
-				}
-			}
-		}
-	}
-}
-
-/*********************************************************************
-\brief Performs the collision handling for all actors.
-*********************************************************************/
-void sysCollision(std::vector<Actor*>& actors, tmx::MapLoader& map)
-{
-	// perform basic actor collision checking
-	actorCollision(actors);
-
-	// perform actor/world collision detection
-	for (auto actor = actors.begin(); actor != actors.end(); actor++) {
-		map.UpdateQuadTree((*actor)->getSprite().getGlobalBounds());
-		std::vector<tmx::MapObject*> temp = map.QueryQuadTree((*actor)->getSprite().getGlobalBounds());
-		for (auto object = temp.begin(); object != temp.end(); object++) {
-			if ((*object)->GetParent() == "Collision" && (*object)->Contains((*actor)->getPosition())) {
-				(*actor)->setPosition((*actor)->getPastPosition());
-				break;
-			}
-		}
-	}
+sf::FloatRect interactionReach(Actor& actor) {
+	const float reach = System::Tilesize * 1.5f;
+	sf::FloatRect box = actor.getCollisionBox();
+	return sf::FloatRect(box.left - reach, box.top - reach, box.width + 2 * reach, box.height + 2 * reach);
 }
 
 /*********************************************************************
@@ -540,35 +539,34 @@ int  _directionOfActor(std::string dir) {
 /*********************************************************************
 \brief Loads the specified map and instantiates all actors and pawns.
 	   The player is set at the start position specified by the map.
+	   Object layers are indexed once and the collision grid is
+	   rebuilt from the Collision layer.
 *********************************************************************/
-void load_map(tmx::MapLoader& ml, std::string map_name, Character& player, std::vector<Actor*>& actors, std::vector<Pawn*>& pawns, std::map<std::string, sf::Texture*> textureMap) {
+void load_map(tmx::MapLoader& ml, MapIndex& index, CollisionMap& collision, std::string map_name, Character& player, std::vector<Actor*>& actors, std::vector<Pawn*>& pawns, std::map<std::string, sf::Texture*> textureMap) {
 	ml.Load(map_name);
+	index.build(ml);
+	collision.build(ml, index.getObjects(index.getLayer("Collision")));
 
-	for (auto layer = ml.GetLayers().begin(); layer != ml.GetLayers().end(); ++layer)
+	const std::vector<tmx::MapObject*>& setup = index.getObjects(index.getLayer("Setup"));
+	for (auto it = setup.begin(); it != setup.end(); it++)
 	{
-		if (layer->name == "Setup")
+		tmx::MapObject* object = *it;
+		if (object->GetName() == "START")
+			player.setPosition(object->GetCentre());
+		else if (object->GetName() == "ACTOR")
 		{
-			for (auto object = layer->objects.begin(); object != layer->objects.end(); object++)
-			{
-				if (object->GetName() == "START")
-					player.setPosition(object->GetCentre());
-				else if (object->GetName() == "ACTOR")
-				{
-					std::string scene_name = object->GetPropertyString("Scene");
-					Actor* ptr = new Actor(*textureMap[object->GetPropertyString("Texture")]);
-					ptr->setScene(scene_name);
-					ptr->setPosition(object->GetCentre());
-					ptr->setPastPosition(ptr->getPosition());
-					ptr->setDirection(_directionOfActor(object->GetPropertyString("Direction")));
-					actors.push_back(ptr);
-				}
-				else if(object->GetName() == "PAWN")
-				{
-					Pawn* ptr = new Pawn(*textureMap[object->GetPropertyString("Texture")]);
-					pawns.push_back(ptr);
-				}
-				
-			}
+			std::string scene_name = object->GetPropertyString("Scene");
+			Actor* ptr = new Actor(*textureMap[object->GetPropertyString("Texture")]);
+			ptr->setScene(scene_name);
+			ptr->setPosition(object->GetCentre());
+			ptr->setPastPosition(ptr->getPosition());
+			ptr->setDirection(_directionOfActor(object->GetPropertyString("Direction")));
+			actors.push_back(ptr);
+		}
+		else if(object->GetName() == "PAWN")
+		{
+			Pawn* ptr = new Pawn(*textureMap[object->GetPropertyString("Texture")]);
+			pawns.push_back(ptr);
 		}
 	}
 }
@@ -1,21 +1,26 @@
 #include <SFML/Graphics.hpp>
 #include "Enums.h"
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 
 namespace sfmath {
 
 	/***********************************************
-	eturns a vector normal
+	Returns a vector normal
+	Each component is reduced to -1, 0 or 1. The magnitudes keep the
+	component type, an int one would truncate components below 1 to
+	zero and divide by it.
 	*********************************************************************/
 	template<typename T>
 	T Normalize(T vector) {
-		int mag_x = 1;
-		int mag_y = 1;
+		decltype(vector.x) mag_x = 1;
+		decltype(vector.y) mag_y = 1;
 
 		if (vector.x != 0)
-			mag_x = sqrt(vector.x*vector.x);
+			mag_x = std::abs(vector.x);
 		if (vector.y != 0)
-			mag_y = sqrt(vector.y*vector.y);
+			mag_y = std::abs(vector.y);
 
 		return T(vector.x/mag_x, vector.y/mag_y);
 	}